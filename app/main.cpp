@@ -1,30 +1,302 @@
+#include <atomic>
+#include <csignal>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
-#include "solver.hpp"
+#include "portfolio.hpp"
 #include "parser.hpp"
+#include "preprocess.hpp"
+
+void usage() {
+    std::cerr << "usage: fousaty [options] [dimacs files]\n"
+              << "options:\n"
+              << "  --restarts=<luby|glucose|mixed>   restart policy ( default glucose )\n"
+              << "  --threads=<n>                     run a portfolio of n diversified solvers\n"
+              << "  --cube-depth=<d>                  cube-and-conquer, split into up to 2^d cubes\n"
+              << "                                    solved by the --threads solvers\n"
+              << "  --proof=<file>                    write a binary proof of UNSAT answers\n"
+              << "  --proof-format=<drat|lrat>        format of the proof ( default drat )\n"
+              << "  --preprocess=<on|off>             simplify the formula before solving ( default on,\n"
+              << "                                    off with --proof )\n"
+              << "  --inprocess=<on|off>              probe and vivify between restarts ( default on )\n"
+              << "  --branching=<evsids|vmtf|mixed|lrb>\n"
+              << "                                    branching heuristic, mixed uses vmtf in focused\n"
+              << "                                    mode ( default evsids )\n"
+              << "  --chrono=<n>                      backtrack chronologically over more than n\n"
+              << "                                    levels, 0 never ( default 100 )\n"
+              << "  --local-search=<on|off|only>      interleave local search with CDCL, or run it\n"
+              << "                                    alone ( default on )\n"
+              << "  --progress=<seconds>              print a progress line every few seconds\n"
+              << "  --stats-json=<file>               write the statistics of each input as JSON\n";
+}
+
+/* set by SIGINT, polled while loading an input */
+std::atomic< bool > interrupt_requested{ false };
+
+/* the portfolio of the current input, stopped by SIGINT */
+std::atomic< portfolio * > running{ nullptr };
+
+void on_interrupt( int ) {
+    // a second interrupt ends the process right away
+    std::signal( SIGINT, SIG_DFL );
+
+    interrupt_requested = true;
+    if ( portfolio *p = running.load() ) {
+        p->interrupt();
+    }
+}
+
+/*
+ * matches options of form --name=value or --name value, advancing _i_ in
+ * the latter case
+ */
+bool option_value( const std::string &arg, const std::string &name, int &i, int argc,
+                   char *argv[], std::string &value ) {
+    if ( arg == name && i + 1 < argc ) {
+        value = argv[++i];
+        return true;
+    }
+
+    if ( arg.rfind( name + "=", 0 ) == 0 ) {
+        value = arg.substr( name.size() + 1 );
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * parses _file_, simplified by the preprocessor if enabled, whose statistics
+ * go to _report_
+ */
+formula load( const std::string &file, bool preprocess, stats_report &report ) {
+    formula f = parse_dimacs( file );
+    if ( !preprocess ) {
+        return f;
+    }
+
+    preprocessor pre( f );
+    pre.terminate = &interrupt_requested;
+    formula simplified = pre.run();
+    pre.collect_stats( report );
+    return simplified;
+}
 
 int main( int argc, char *argv[] ){
 
-    if ( argc == 1 ) {
+    solver_options opts;
+    proof_format format = proof_format::DRAT;
+    bool preprocess = true;
+    std::string stats_path;
+    std::vector< std::string > files;
+
+    for ( int i = 1; i < argc; ++i ) {
+        std::string arg = argv[i];
+        std::string value;
+
+        if ( arg.rfind( "--", 0 ) != 0 ) {
+            files.push_back( arg );
+        }
+        else if ( option_value( arg, "--restarts", i, argc, argv, value ) ) {
+            if ( !parse_restart_kind( value, opts.restarts ) ) {
+                std::cerr << "unknown restart policy: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--threads", i, argc, argv, value ) ) {
+            try {
+                opts.threads = std::stoi( value );
+            } catch ( const std::exception & ) {
+                opts.threads = 0;
+            }
+            if ( opts.threads < 1 ) {
+                std::cerr << "invalid number of threads: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--cube-depth", i, argc, argv, value ) ) {
+            try {
+                opts.cube_depth = std::stoi( value );
+            } catch ( const std::exception & ) {
+                opts.cube_depth = -1;
+            }
+            if ( opts.cube_depth < 0 ) {
+                std::cerr << "invalid cube depth: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--proof", i, argc, argv, value ) ) {
+            opts.proof_path = value;
+        }
+        else if ( option_value( arg, "--proof-format", i, argc, argv, value ) ) {
+            if ( !parse_proof_format( value, format ) ) {
+                std::cerr << "unknown proof format: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--preprocess", i, argc, argv, value ) ) {
+            if ( value != "on" && value != "off" ) {
+                std::cerr << "unknown preprocessing mode: " << value << "\n";
+                usage();
+                return 1;
+            }
+            preprocess = ( value == "on" );
+        }
+        else if ( option_value( arg, "--inprocess", i, argc, argv, value ) ) {
+            if ( value != "on" && value != "off" ) {
+                std::cerr << "unknown inprocessing mode: " << value << "\n";
+                usage();
+                return 1;
+            }
+            opts.inprocess = ( value == "on" );
+        }
+        else if ( option_value( arg, "--branching", i, argc, argv, value ) ) {
+            if ( !parse_branching_kind( value, opts.branching ) ) {
+                std::cerr << "unknown branching heuristic: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--chrono", i, argc, argv, value ) ) {
+            try {
+                opts.chrono_levels = std::stoi( value );
+            } catch ( const std::exception & ) {
+                opts.chrono_levels = -1;
+            }
+            if ( opts.chrono_levels < 0 ) {
+                std::cerr << "invalid number of chrono levels: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--local-search", i, argc, argv, value ) ) {
+            if ( !parse_local_search_kind( value, opts.local_search ) ) {
+                std::cerr << "unknown local search mode: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--progress", i, argc, argv, value ) ) {
+            try {
+                opts.report_interval = std::stod( value );
+            } catch ( const std::exception & ) {
+                opts.report_interval = -1;
+            }
+            if ( opts.report_interval <= 0 ) {
+                std::cerr << "invalid progress interval: " << value << "\n";
+                usage();
+                return 1;
+            }
+        }
+        else if ( option_value( arg, "--stats-json", i, argc, argv, value ) ) {
+            stats_path = value;
+        }
+        else {
+            std::cerr << "unknown option: " << arg << "\n";
+            usage();
+            return 1;
+        }
+    }
+
+    if ( !opts.proof_path.empty() ) {
+        opts.proof = format;
+
+        // the steps of preprocessing are not logged
+        preprocess = false;
+
+        // learnt clauses of other solvers and refuted cubes are not logged
+        if ( opts.threads > 1 || opts.cube_depth > 0 || files.size() > 1 ) {
+            std::cerr << "--proof needs a single input and solver\n";
+            return 1;
+        }
+    }
+
+    if ( files.empty() ) {
         std::cout << "UNKNOWN\n";
         return 0;
     }
 
+    std::ofstream stats_json;
+    if ( !stats_path.empty() ) {
+        stats_json.open( stats_path );
+        if ( !stats_json ) {
+            std::cerr << "cannot write statistics to " << stats_path << "\n";
+            return 1;
+        }
+        stats_json << "[";
+    }
+
+    std::signal( SIGINT, on_interrupt );
+
     std::string res;
+    int status = 0;
 
-    for ( int i = 1; i < argc; ++i ) {
-        
-        formula f = parse_dimacs( argv[i] );
-        solver s = solver( std::move( f ) );
+    for ( std::size_t k = 0; k < files.size(); ++k ) {
+        const std::string &file = files[k];
+
+        stats_report report;
+        formula f = load( file, preprocess, report );
+        report.print( std::cout );
+
+        portfolio p( std::move( f ), opts );
 
-        bool satisfiable = s.solve();
+        // an interrupt before the portfolio was published stops it here
+        running = &p;
+        if ( interrupt_requested ) {
+            p.interrupt();
+        }
+
+        lbool result = p.solve();
+        running = nullptr;
+
+        stats_report search;
+        p.collect_stats( search );
+        search.print( std::cout );
+        report.append( search );
+
+        solver &s = p.best();
+
+        // a truncated proof must not pass for a complete one
+        if ( !s.close_proof() ) {
+            std::cerr << "error: failed to write the proof to " << opts.proof_path << "\n";
+            status = 1;
+        }
+
+        if ( stats_json.is_open() ) {
+            stats_report entry;
+            entry.add( "file", file );
+            entry.add( "result", !result ? "UNKNOWN"
+                                 : *result ? "SATISFIABLE" : "UNSATISFIABLE" );
+            entry.append( report );
+
+            stats_json << ( k ? ",\n  " : "\n  " );
+            entry.print_json( stats_json );
+        }
+
+        // interrupted, the remaining inputs are skipped
+        if ( !result ) {
+            std::cout << "s UNKNOWN\n";
+            break;
+        }
+
+        bool satisfiable = *result;
         res = satisfiable ? "s SATISFIABLE" : "s UNSATISFIABLE";
         std::cout << res << "\n";
 
-        if ( satisfiable )
+        if ( satisfiable ) {
             std::cout << s.get_model_string();
-            s.output_model( "../test/model_file.txt" );
+        }
+    }
+
+    if ( stats_json.is_open() ) {
+        stats_json << "\n]\n";
     }
 
-    return 0;
+    return status;
 }
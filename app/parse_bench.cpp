@@ -0,0 +1,34 @@
+#include <chrono>
+#include <iostream>
+
+#include "parser.hpp"
+
+/*
+ * measures the time spent in parse_dimacs for each of the given files
+ */
+int main( int argc, char *argv[] ){
+
+    if ( argc == 1 ) {
+        std::cout << "usage: fousaty-parse-bench [dimacs files]\n";
+        return 0;
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    double total = 0;
+    std::size_t clauses = 0;
+
+    for ( int i = 1; i < argc; ++i ) {
+        auto start = clock::now();
+        formula f = parse_dimacs( argv[i] );
+        std::chrono::duration< double > elapsed = clock::now() - start;
+
+        total += elapsed.count();
+        clauses += f.clause_count;
+    }
+
+    std::cout << "c parsed " << argc - 1 << " files, " << clauses << " clauses in "
+              << total * 1000 << " ms\n";
+
+    return 0;
+}
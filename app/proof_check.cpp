@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * standalone checker of the binary DRAT and LRAT proofs written by
+ * fousaty --proof, see src/proof.hpp for the format. It only accepts RUP
+ * steps, which is all the solver produces. DRAT is checked forward, every
+ * lemma by unit propagation over the current clauses, deletions of clauses
+ * that are reasons of level 0 units keep the units, like drat-trim does.
+ *
+ * usage: fousaty-check [--lrat] <dimacs file> <proof file>
+ */
+
+/* literals are coded as in the proof, 2 * var + sign */
+using clause_lits = std::vector< uint32_t >;
+
+uint32_t negate( uint32_t l ) {
+    return l ^ 1;
+}
+
+bool read_dimacs( const std::string &path, std::vector< clause_lits > &clauses, int &vars ) {
+    std::ifstream in( path );
+    if ( !in ) {
+        return false;
+    }
+
+    std::string tok;
+    clause_lits curr;
+    vars = 0;
+
+    while ( in >> tok ) {
+        if ( tok == "c" ) {
+            std::getline( in, tok );
+        }
+        else if ( tok == "p" ) {
+            int count;
+            in >> tok >> vars >> count;
+        }
+        else if ( tok == "%" ) {
+            break;
+        }
+        else {
+            int l = std::stoi( tok );
+            if ( l == 0 ) {
+                clauses.push_back( curr );
+                curr.clear();
+                continue;
+            }
+            vars = std::max( vars, std::abs( l ) );
+            curr.push_back( 2 * std::abs( l ) + ( l < 0 ) );
+        }
+    }
+
+    if ( !curr.empty() ) {
+        clauses.push_back( curr );
+    }
+
+    return true;
+}
+
+struct proof_reader {
+    std::vector< unsigned char > data;
+    std::size_t pos = 0;
+
+    bool at_end() const {
+        return pos >= data.size();
+    }
+
+    int step() {
+        return data[pos++];
+    }
+
+    bool number( uint64_t &x ) {
+        x = 0;
+        for ( int shift = 0; ; shift += 7 ) {
+            if ( at_end() || shift > 63 ) {
+                return false;
+            }
+            unsigned char b = data[pos++];
+            x |= uint64_t( b & 127 ) << shift;
+            if ( !( b & 128 ) ) {
+                return true;
+            }
+        }
+    }
+
+    /* numbers up to the terminating 0 */
+    bool numbers( std::vector< uint64_t > &out ) {
+        out.clear();
+        uint64_t x;
+        while ( number( x ) ) {
+            if ( x == 0 ) {
+                return true;
+            }
+            out.push_back( x );
+        }
+        return false;
+    }
+};
+
+struct checker {
+
+    int vars;
+
+    /* value of every literal, 1 true, -1 false, 0 unassigned */
+    std::vector< int8_t > vals;
+    std::vector< uint32_t > trail;
+
+    long long lemmas = 0;
+    long long deletions = 0;
+    bool refuted = false;
+
+    explicit checker( int vars ) : vars( vars ), vals( 2 * vars + 2 ) { }
+
+    void grow( uint32_t l ) {
+        if ( l / 2 > (uint32_t) vars ) {
+            vars = l / 2;
+            vals.resize( 2 * vars + 2 );
+        }
+    }
+
+    void assign( uint32_t l ) {
+        vals[l] = 1;
+        vals[negate( l )] = -1;
+        trail.push_back( l );
+    }
+
+    void undo( std::size_t size ) {
+        while ( trail.size() > size ) {
+            uint32_t l = trail.back();
+            vals[l] = vals[negate( l )] = 0;
+            trail.pop_back();
+        }
+    }
+};
+
+/* forward DRAT checking with two watched literals */
+struct drat_checker : checker {
+
+    std::vector< clause_lits > clauses;
+    std::vector< bool > deleted;
+    std::vector< std::vector< std::size_t > > watches;
+
+    /* clauses by their sorted literals, for deletions */
+    std::unordered_multimap< uint64_t, std::size_t > index;
+
+    std::size_t head = 0;
+
+    /* the top level assignment is conflicting */
+    bool inconsistent = false;
+
+    explicit drat_checker( int vars ) : checker( vars ), watches( 2 * vars + 2 ) { }
+
+    static uint64_t hash( const clause_lits &lits ) {
+        uint64_t h = 1469598103934665603ull;
+        for ( uint32_t l : lits ) {
+            h = ( h ^ l ) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    void grow( uint32_t l ) {
+        checker::grow( l );
+        watches.resize( vals.size() );
+    }
+
+    bool propagate() {
+        while ( head < trail.size() ) {
+            uint32_t f = negate( trail[head++] );
+            std::vector< std::size_t > &ws = watches[f];
+
+            std::size_t j = 0;
+            for ( std::size_t i = 0; i < ws.size(); ++i ) {
+                std::size_t ci = ws[i];
+                if ( deleted[ci] ) {
+                    continue;
+                }
+
+                clause_lits &c = clauses[ci];
+                if ( c[0] == f ) {
+                    std::swap( c[0], c[1] );
+                }
+
+                if ( vals[c[0]] > 0 ) {
+                    ws[j++] = ci;
+                    continue;
+                }
+
+                bool moved = false;
+                for ( std::size_t k = 2; k < c.size(); ++k ) {
+                    if ( vals[c[k]] >= 0 ) {
+                        std::swap( c[1], c[k] );
+                        watches[c[1]].push_back( ci );
+                        moved = true;
+                        break;
+                    }
+                }
+
+                if ( moved ) {
+                    continue;
+                }
+
+                ws[j++] = ci;
+                if ( vals[c[0]] < 0 ) {
+                    for ( ++i; i < ws.size(); ++i ) {
+                        ws[j++] = ws[i];
+                    }
+                    ws.resize( j );
+                    return false;
+                }
+
+                assign( c[0] );
+            }
+            ws.resize( j );
+        }
+        return true;
+    }
+
+    void add( clause_lits lits ) {
+        std::sort( lits.begin(), lits.end() );
+        lits.erase( std::unique( lits.begin(), lits.end() ), lits.end() );
+        for ( uint32_t l : lits ) {
+            grow( l );
+        }
+
+        std::size_t ci = clauses.size();
+        index.emplace( hash( lits ), ci );
+        deleted.push_back( false );
+        clauses.push_back( lits );
+
+        if ( inconsistent ) {
+            return;
+        }
+
+        clause_lits &c = clauses[ci];
+
+        // watch non false literals, true ones first
+        std::stable_sort( c.begin(), c.end(), [&]( uint32_t a, uint32_t b ) {
+            return vals[a] > vals[b];
+        } );
+
+        if ( c.empty() || vals[c[0]] < 0 ) {
+            inconsistent = true;
+            return;
+        }
+
+        if ( c.size() == 1 || vals[c[1]] < 0 ) {
+            if ( vals[c[0]] == 0 ) {
+                assign( c[0] );
+            }
+            if ( c.size() > 1 ) {
+                watches[c[0]].push_back( ci );
+                watches[c[1]].push_back( ci );
+            }
+            inconsistent = !propagate();
+            return;
+        }
+
+        watches[c[0]].push_back( ci );
+        watches[c[1]].push_back( ci );
+    }
+
+    bool rup( const clause_lits &lemma ) {
+        if ( inconsistent ) {
+            return true;
+        }
+
+        std::size_t size = trail.size();
+        bool conflict = false;
+
+        for ( uint32_t l : lemma ) {
+            grow( l );
+            if ( vals[l] > 0 ) {
+                conflict = true;
+                break;
+            }
+            if ( vals[l] == 0 ) {
+                assign( negate( l ) );
+            }
+        }
+
+        if ( !conflict ) {
+            conflict = !propagate();
+        }
+
+        undo( size );
+        head = size;
+        return conflict;
+    }
+
+    void remove( clause_lits lits ) {
+        std::sort( lits.begin(), lits.end() );
+        lits.erase( std::unique( lits.begin(), lits.end() ), lits.end() );
+
+        auto [from, to] = index.equal_range( hash( lits ) );
+        for ( auto it = from; it != to; ++it ) {
+            clause_lits sorted = clauses[it->second];
+            std::sort( sorted.begin(), sorted.end() );
+            if ( sorted == lits ) {
+                deleted[it->second] = true;
+                index.erase( it );
+                deletions++;
+                return;
+            }
+        }
+    }
+
+    bool check( proof_reader &proof ) {
+        std::vector< uint64_t > nums;
+        while ( !proof.at_end() ) {
+            int kind = proof.step();
+            if ( ( kind != 'a' && kind != 'd' ) || !proof.numbers( nums ) ) {
+                std::cerr << "c malformed proof at byte " << proof.pos << "\n";
+                return false;
+            }
+
+            clause_lits lits( nums.begin(), nums.end() );
+            if ( kind == 'd' ) {
+                remove( lits );
+                continue;
+            }
+
+            lemmas++;
+            if ( !rup( lits ) ) {
+                std::cerr << "c lemma " << lemmas << " is not RUP\n";
+                return false;
+            }
+
+            if ( lits.empty() ) {
+                refuted = true;
+                return true;
+            }
+
+            add( lits );
+        }
+
+        std::cerr << "c the proof does not derive the empty clause\n";
+        return false;
+    }
+};
+
+/* LRAT checking, every hint has to be unit or falsified in order */
+struct lrat_checker : checker {
+
+    std::unordered_map< uint64_t, clause_lits > clauses;
+
+    using checker::checker;
+
+    bool derive( const clause_lits &lits, const std::vector< uint64_t > &hints ) {
+        bool conflict = false;
+
+        for ( uint32_t l : lits ) {
+            grow( l );
+            if ( vals[l] > 0 ) {
+                conflict = true;
+            }
+            else if ( vals[l] == 0 ) {
+                assign( negate( l ) );
+            }
+        }
+
+        for ( std::size_t i = 0; i < hints.size() && !conflict; ++i ) {
+            auto it = clauses.find( hints[i] );
+            if ( it == clauses.end() ) {
+                break;
+            }
+
+            uint32_t unit = 0;
+            int open = 0;
+            bool satisfied = false;
+            for ( uint32_t l : it->second ) {
+                grow( l );
+                if ( vals[l] > 0 ) { satisfied = true; }
+                else if ( vals[l] == 0 && l != unit ) { unit = l; open++; }
+            }
+
+            if ( satisfied || open > 1 ) {
+                break;
+            }
+
+            if ( open == 0 ) {
+                conflict = true;
+            } else {
+                assign( unit );
+            }
+        }
+
+        undo( 0 );
+        return conflict;
+    }
+
+    bool check( proof_reader &proof ) {
+        std::vector< uint64_t > nums, hints;
+        uint64_t id;
+
+        while ( !proof.at_end() ) {
+            int kind = proof.step();
+
+            if ( kind == 'd' ) {
+                if ( !proof.numbers( nums ) ) {
+                    break;
+                }
+                for ( uint64_t x : nums ) {
+                    deletions += clauses.erase( x / 2 );
+                }
+                continue;
+            }
+
+            if ( kind != 'a' || !proof.number( id ) || !proof.numbers( nums )
+                 || !proof.numbers( hints ) ) {
+                std::cerr << "c malformed proof at byte " << proof.pos << "\n";
+                return false;
+            }
+
+            for ( uint64_t &h : hints ) {
+                h /= 2;
+            }
+
+            lemmas++;
+            clause_lits lits( nums.begin(), nums.end() );
+            if ( !derive( lits, hints ) ) {
+                std::cerr << "c lemma " << id / 2 << " does not follow from its hints\n";
+                return false;
+            }
+
+            if ( lits.empty() ) {
+                refuted = true;
+                return true;
+            }
+
+            clauses[id / 2] = std::move( lits );
+        }
+
+        std::cerr << "c the proof does not derive the empty clause\n";
+        return false;
+    }
+};
+
+int main( int argc, char *argv[] ) {
+    bool lrat = false;
+    std::vector< std::string > files;
+
+    for ( int i = 1; i < argc; ++i ) {
+        std::string arg = argv[i];
+        if ( arg == "--lrat" ) {
+            lrat = true;
+        } else {
+            files.push_back( arg );
+        }
+    }
+
+    if ( files.size() != 2 ) {
+        std::cerr << "usage: fousaty-check [--lrat] <dimacs file> <proof file>\n";
+        return 2;
+    }
+
+    std::vector< clause_lits > clauses;
+    int vars;
+    if ( !read_dimacs( files[0], clauses, vars ) ) {
+        std::cerr << "cannot read " << files[0] << "\n";
+        return 2;
+    }
+
+    std::ifstream in( files[1], std::ios::binary );
+    if ( !in ) {
+        std::cerr << "cannot read " << files[1] << "\n";
+        return 2;
+    }
+
+    proof_reader proof;
+    proof.data.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+
+    bool ok;
+    long long lemmas = 0, deletions = 0;
+
+    // an empty input clause needs no proof
+    if ( std::any_of( clauses.begin(), clauses.end(),
+                      []( const clause_lits &c ) { return c.empty(); } ) ) {
+        ok = true;
+    }
+    else if ( lrat ) {
+        lrat_checker c( vars );
+        for ( std::size_t i = 0; i < clauses.size(); ++i ) {
+            c.clauses[i + 1] = clauses[i];
+        }
+        ok = c.check( proof );
+        lemmas = c.lemmas;
+        deletions = c.deletions;
+    }
+    else {
+        drat_checker c( vars );
+        for ( const clause_lits &cl : clauses ) {
+            c.add( cl );
+        }
+        ok = c.check( proof );
+        lemmas = c.lemmas;
+        deletions = c.deletions;
+    }
+
+    std::cout << "c lemmas:    " << lemmas << "\n"
+              << "c deletions: " << deletions << "\n"
+              << ( ok ? "s VERIFIED" : "s NOT VERIFIED" ) << "\n";
+
+    return ok ? 0 : 1;
+}
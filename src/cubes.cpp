@@ -0,0 +1,124 @@
+#include "cubes.hpp"
+#include <algorithm>
+
+cube_generator::cube_generator( solver &s, int depth ) : s( s ), depth( depth ) {
+    std::vector< int > occurrences( s.form.var_count + 1 );
+    for ( cref_t ref : s.form.base ) {
+        for ( lit_t l : s.form[ref] ) {
+            occurrences[l.var()]++;
+        }
+    }
+
+    for ( var_t v = 1; v <= s.form.var_count; ++v ) {
+        if ( !s.form.extension.is_eliminated( v ) ) {
+            order.push_back( v );
+        }
+    }
+
+    std::stable_sort( order.begin(), order.end(), [&]( var_t a, var_t b ) {
+        return occurrences[a] > occurrences[b];
+    } );
+}
+
+bool cube_generator::generate() {
+    if ( s.unsat || !s.unit_propagation() ) {
+        return false;
+    }
+
+    split( 0 );
+    return !cubes.empty() && !s.interrupted();
+}
+
+int cube_generator::probe( lit_t l ) {
+    lookaheads++;
+
+    int level = s.current_level();
+    std::size_t before = s.trail.size();
+
+    s.decide( l.var(), l.pol() );
+    bool ok = s.unit_propagation();
+    int implied = s.trail.size() - before;
+
+    s.backtrack( level );
+    return ok ? implied : -1;
+}
+
+void cube_generator::split( int branches ) {
+    // the cubes so far are discarded by the caller
+    if ( s.interrupted() ) {
+        return;
+    }
+
+    if ( branches == depth ) {
+        cubes.push_back( cube );
+        return;
+    }
+
+    var_t best = 0;
+    long long best_score = -1;
+    lit_t forced;
+
+    int tried = 0;
+    for ( var_t v : order ) {
+        if ( tried == candidates ) {
+            break;
+        }
+        if ( !s.asgn.var_unassigned( v ) ) {
+            continue;
+        }
+        tried++;
+
+        int pos = probe( lit_t( v, true ) );
+        int neg = probe( lit_t( v, false ) );
+
+        if ( pos < 0 && neg < 0 ) {
+            refuted_nodes++;
+            return;
+        }
+
+        if ( pos < 0 || neg < 0 ) {
+            forced = lit_t( v, neg < 0 );
+            break;
+        }
+
+        long long score = (long long) ( pos + 1 ) * ( neg + 1 );
+        if ( score > best_score ) {
+            best_score = score;
+            best = v;
+        }
+    }
+
+    // everything assigned, the cube is a model candidate
+    if ( !forced.defined() && best == 0 ) {
+        cubes.push_back( cube );
+        return;
+    }
+
+    std::vector< lit_t > branch;
+    if ( forced.defined() ) {
+        failed_literals++;
+        branch = { forced };
+    } else {
+        branch = { lit_t( best, true ), lit_t( best, false ) };
+    }
+
+    int level = s.current_level();
+    for ( lit_t l : branch ) {
+        // the probe of _l_ succeeded, no conflict here
+        s.decide( l.var(), l.pol() );
+        s.unit_propagation();
+
+        cube.push_back( l );
+        split( branches + !forced.defined() );
+        cube.pop_back();
+
+        s.backtrack( level );
+    }
+}
+
+void cube_generator::collect_stats( stats_report &report ) const {
+    report.add( "cubes", (long long) cubes.size() );
+    report.add( "lookaheads", lookaheads );
+    report.add( "cube failed lits", failed_literals );
+    report.add( "refuted nodes", refuted_nodes );
+}
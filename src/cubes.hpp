@@ -0,0 +1,52 @@
+#pragma once
+#include "solver.hpp"
+#include "stats.hpp"
+#include <vector>
+
+/*
+ * CUBE GENERATION
+ *
+ * splits the formula into cubes ( conjunctions of literals ) by lookahead:
+ * at each node the candidate variables are decided both ways on the
+ * propagation engine of _s_, the variable maximizing the product of the
+ * numbers of implied literals is branched on. A literal whose decision
+ * fails is negated into the cube instead of branching, a node where both
+ * phases of a candidate fail has no cubes. Together with the refuted nodes,
+ * the cubes cover all assignments of the formula.
+ */
+struct cube_generator {
+
+    /* lookahead candidates per node, picked by number of occurrences */
+    static constexpr int candidates = 32;
+
+    solver &s;
+
+    /* number of branching decisions of a cube */
+    int depth;
+
+    /* variables ordered by occurrences in the formula, most frequent first */
+    std::vector< var_t > order;
+
+    std::vector< lit_t > cube;
+    std::vector< std::vector< lit_t > > cubes;
+
+    /* STATISTICS */
+    long long lookaheads = 0;
+    long long failed_literals = 0;
+    long long refuted_nodes = 0;
+
+    cube_generator( solver &s, int depth );
+
+    /* generates the cubes, false if the formula is refuted on the way or
+     * the terminate flag of _s_ is set */
+    bool generate();
+
+    void collect_stats( stats_report &report ) const;
+
+private:
+
+    /* number of literals implied by _l_, -1 if it leads to a conflict */
+    int probe( lit_t l );
+
+    void split( int branches );
+};
@@ -0,0 +1,265 @@
+#include "decompress.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef FOUSATY_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef FOUSATY_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#ifdef FOUSATY_HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
+compression detect_compression( int fd ) {
+    unsigned char magic[6] = {};
+    ssize_t n;
+    do {
+        n = ::pread( fd, magic, sizeof( magic ), 0 );
+    } while ( n == -1 && errno == EINTR );
+
+    if ( n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b ) {
+        return compression::GZIP;
+    }
+
+    static const unsigned char xz_magic[6] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+    if ( n >= 6 && std::memcmp( magic, xz_magic, 6 ) == 0 ) {
+        return compression::XZ;
+    }
+
+    if ( n >= 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h' ) {
+        return compression::BZIP2;
+    }
+
+    return compression::NONE;
+}
+
+/*
+ * common part of the decoders, pulls compressed bytes from the file through
+ * a fixed buffer
+ */
+struct compressed_input : stream_decoder {
+
+    static constexpr std::size_t chunk_size = 1 << 18;
+
+    int fd;
+    std::vector< char > in;
+
+    explicit compressed_input( int fd ) : fd( fd ), in( chunk_size ) { }
+
+    /* reads next chunk of compressed data, returns 0 at the end of file */
+    std::size_t fill() {
+        ssize_t n;
+        do {
+            n = ::read( fd, in.data(), in.size() );
+        } while ( n == -1 && errno == EINTR );
+
+        if ( n < 0 ) {
+            throw std::runtime_error( "parser error, failed to read input" );
+        }
+
+        return n;
+    }
+
+    [[noreturn]] static void fail( const char *what ) {
+        throw std::runtime_error( std::string( "parser error, corrupted " ) + what + " input" );
+    }
+};
+
+#ifdef FOUSATY_HAVE_ZLIB
+struct gzip_decoder : compressed_input {
+
+    z_stream zs{};
+
+    /* set after a member ends, the input may legally stop here */
+    bool member_done = true;
+
+    explicit gzip_decoder( int fd ) : compressed_input( fd ) {
+        // 15 + 32 -> max window, gzip / zlib header detected automatically
+        if ( inflateInit2( &zs, 15 + 32 ) != Z_OK ) {
+            throw std::runtime_error( "parser error, failed to initialize zlib" );
+        }
+    }
+
+    ~gzip_decoder() override {
+        inflateEnd( &zs );
+    }
+
+    std::size_t read( char *out, std::size_t cap ) override {
+        zs.next_out = reinterpret_cast< Bytef * >( out );
+        zs.avail_out = cap;
+
+        while ( zs.avail_out == cap ) {
+            if ( zs.avail_in == 0 ) {
+                std::size_t n = fill();
+                if ( n == 0 ) {
+                    if ( !member_done ) { fail( "gzip" ); }
+                    break;
+                }
+                zs.next_in = reinterpret_cast< Bytef * >( in.data() );
+                zs.avail_in = n;
+            }
+
+            member_done = false;
+            int ret = inflate( &zs, Z_NO_FLUSH );
+
+            // concatenated gzip members are decoded as one stream
+            if ( ret == Z_STREAM_END ) {
+                member_done = true;
+                inflateReset( &zs );
+            }
+            else if ( ret != Z_OK && ret != Z_BUF_ERROR ) {
+                fail( "gzip" );
+            }
+        }
+
+        return cap - zs.avail_out;
+    }
+};
+#endif
+
+#ifdef FOUSATY_HAVE_LZMA
+struct xz_decoder : compressed_input {
+
+    lzma_stream strm = LZMA_STREAM_INIT;
+    lzma_action action = LZMA_RUN;
+    bool done = false;
+
+    explicit xz_decoder( int fd ) : compressed_input( fd ) {
+        if ( lzma_stream_decoder( &strm, UINT64_MAX, LZMA_CONCATENATED ) != LZMA_OK ) {
+            throw std::runtime_error( "parser error, failed to initialize lzma" );
+        }
+    }
+
+    ~xz_decoder() override {
+        lzma_end( &strm );
+    }
+
+    std::size_t read( char *out, std::size_t cap ) override {
+        strm.next_out = reinterpret_cast< uint8_t * >( out );
+        strm.avail_out = cap;
+
+        while ( !done && strm.avail_out == cap ) {
+            if ( strm.avail_in == 0 && action == LZMA_RUN ) {
+                std::size_t n = fill();
+                if ( n == 0 ) {
+                    action = LZMA_FINISH;
+                }
+                strm.next_in = reinterpret_cast< const uint8_t * >( in.data() );
+                strm.avail_in = n;
+            }
+
+            lzma_ret ret = lzma_code( &strm, action );
+
+            if ( ret == LZMA_STREAM_END ) {
+                done = true;
+            }
+            else if ( ret != LZMA_OK ) {
+                fail( "xz" );
+            }
+        }
+
+        return cap - strm.avail_out;
+    }
+};
+#endif
+
+#ifdef FOUSATY_HAVE_BZIP2
+struct bzip2_decoder : compressed_input {
+
+    bz_stream bs{};
+    bool member_done = true;
+
+    explicit bzip2_decoder( int fd ) : compressed_input( fd ) {
+        init();
+    }
+
+    ~bzip2_decoder() override {
+        BZ2_bzDecompressEnd( &bs );
+    }
+
+    void init() {
+        if ( BZ2_bzDecompressInit( &bs, 0, 0 ) != BZ_OK ) {
+            throw std::runtime_error( "parser error, failed to initialize bzip2" );
+        }
+    }
+
+    std::size_t read( char *out, std::size_t cap ) override {
+        bs.next_out = out;
+        bs.avail_out = cap;
+
+        while ( bs.avail_out == cap ) {
+            if ( bs.avail_in == 0 ) {
+                std::size_t n = fill();
+                if ( n == 0 ) {
+                    if ( !member_done ) { fail( "bzip2" ); }
+                    break;
+                }
+                bs.next_in = in.data();
+                bs.avail_in = n;
+            }
+
+            member_done = false;
+            int ret = BZ2_bzDecompress( &bs );
+
+            // restart the decoder for concatenated streams ( pbzip2 output )
+            if ( ret == BZ_STREAM_END ) {
+                member_done = true;
+
+                char *next_in = bs.next_in;
+                unsigned avail_in = bs.avail_in;
+                char *next_out = bs.next_out;
+                unsigned avail_out = bs.avail_out;
+
+                BZ2_bzDecompressEnd( &bs );
+                bs = bz_stream{};
+                init();
+
+                bs.next_in = next_in;
+                bs.avail_in = avail_in;
+                bs.next_out = next_out;
+                bs.avail_out = avail_out;
+            }
+            else if ( ret != BZ_OK ) {
+                fail( "bzip2" );
+            }
+        }
+
+        return cap - bs.avail_out;
+    }
+};
+#endif
+
+std::unique_ptr< stream_decoder > make_decoder( int fd ) {
+    switch ( detect_compression( fd ) ) {
+        case compression::GZIP:
+#ifdef FOUSATY_HAVE_ZLIB
+            return std::make_unique< gzip_decoder >( fd );
+#else
+            throw std::runtime_error( "parser error, built without gzip support" );
+#endif
+        case compression::XZ:
+#ifdef FOUSATY_HAVE_LZMA
+            return std::make_unique< xz_decoder >( fd );
+#else
+            throw std::runtime_error( "parser error, built without xz support" );
+#endif
+        case compression::BZIP2:
+#ifdef FOUSATY_HAVE_BZIP2
+            return std::make_unique< bzip2_decoder >( fd );
+#else
+            throw std::runtime_error( "parser error, built without bzip2 support" );
+#endif
+        default:
+            return nullptr;
+    }
+}
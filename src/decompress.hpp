@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+/*
+ * streaming decompression of parser input
+ *
+ * the compression format is detected from the magic bytes at the start of
+ * the file, the decoders only keep fixed size buffers, so memory use does not
+ * depend on the size of the uncompressed formula
+ */
+
+enum class compression {
+    NONE, GZIP, XZ, BZIP2
+};
+
+struct stream_decoder {
+
+    virtual ~stream_decoder() = default;
+
+    /* decodes up to _cap_ bytes into _out_, returns 0 at the end of input */
+    virtual std::size_t read( char *out, std::size_t cap ) = 0;
+};
+
+/* inspects the first bytes of the file, does not move the file offset */
+compression detect_compression( int fd );
+
+/* returns decoder reading from _fd_, nullptr for uncompressed input */
+std::unique_ptr< stream_decoder > make_decoder( int fd );
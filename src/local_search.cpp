@@ -0,0 +1,155 @@
+#include "local_search.hpp"
+#include <cmath>
+
+local_search::local_search( const formula &form, uint32_t seed )
+                          : vars( form.var_count ), values( form.var_count + 1 ),
+                            rng( seed ) {
+    occ_starts.assign( 2 * vars + 3, 0 );
+
+    starts.push_back( 0 );
+    for ( cref_t ref : form.base ) {
+        const clause &c = form[ref];
+        for ( lit_t l : c ) {
+            lits.push_back( l );
+            occ_starts[l.code + 1]++;
+        }
+        starts.push_back( lits.size() );
+    }
+
+    // counts to offsets, then fill by clause
+    for ( std::size_t code = 1; code < occ_starts.size(); ++code ) {
+        occ_starts[code] += occ_starts[code - 1];
+    }
+
+    occ.resize( lits.size() );
+    std::vector< uint32_t > fill( occ_starts.begin(), occ_starts.end() - 1 );
+    for ( uint32_t c = 0; c < clause_count(); ++c ) {
+        for ( uint32_t i = starts[c]; i < starts[c + 1]; ++i ) {
+            occ[fill[lits[i].code]++] = c;
+        }
+    }
+
+    true_count.resize( clause_count() );
+    true_xor.resize( clause_count() );
+    unsat_pos.resize( clause_count() );
+    breaks.resize( vars + 1 );
+
+    // poly break of ProbSAT, tuned for 3-SAT
+    const double eps = 1, cb = 2.38;
+    for ( int b = 0; b < 64; ++b ) {
+        probs.push_back( std::pow( eps + b, -cb ) );
+    }
+}
+
+void local_search::reset( const std::vector< lbool > &phases ) {
+    resets++;
+
+    for ( var_t v = 1; v <= vars; ++v ) {
+        values[v] = phases[v] ? *phases[v] : bool( rng() % 2 );
+    }
+
+    std::fill( breaks.begin(), breaks.end(), 0 );
+    unsat.clear();
+
+    for ( uint32_t c = 0; c < clause_count(); ++c ) {
+        true_count[c] = 0;
+        true_xor[c] = 0;
+        for ( uint32_t i = starts[c]; i < starts[c + 1]; ++i ) {
+            if ( satisfies( lits[i] ) ) {
+                true_count[c]++;
+                true_xor[c] ^= lits[i].var();
+            }
+        }
+
+        if ( true_count[c] == 0 ) {
+            make_unsat( c );
+        } else if ( true_count[c] == 1 ) {
+            breaks[true_xor[c]]++;
+        }
+    }
+
+    best = values;
+    best_unsat = unsat.size();
+}
+
+void local_search::make_unsat( uint32_t c ) {
+    unsat_pos[c] = unsat.size();
+    unsat.push_back( c );
+}
+
+void local_search::make_sat( uint32_t c ) {
+    uint32_t last = unsat.back();
+    unsat[unsat_pos[c]] = last;
+    unsat_pos[last] = unsat_pos[c];
+    unsat.pop_back();
+}
+
+void local_search::flip( var_t v ) {
+    flips++;
+    values[v] = !values[v];
+
+    lit_t t( v, values[v] );
+    lit_t f = -t;
+
+    for ( uint32_t k = occ_starts[t.code]; k < occ_starts[t.code + 1]; ++k ) {
+        uint32_t c = occ[k];
+        if ( true_count[c] == 0 ) {
+            make_sat( c );
+            breaks[v]++;
+        }
+        else if ( true_count[c] == 1 ) {
+            // the critical variable is not critical anymore
+            breaks[true_xor[c]]--;
+        }
+        true_count[c]++;
+        true_xor[c] ^= v;
+    }
+
+    for ( uint32_t k = occ_starts[f.code]; k < occ_starts[f.code + 1]; ++k ) {
+        uint32_t c = occ[k];
+        true_count[c]--;
+        true_xor[c] ^= v;
+        if ( true_count[c] == 0 ) {
+            make_unsat( c );
+            breaks[v]--;
+        }
+        else if ( true_count[c] == 1 ) {
+            breaks[true_xor[c]]++;
+        }
+    }
+}
+
+bool local_search::run( long long max_flips ) {
+    for ( long long n = 0; n < max_flips && !unsat.empty(); ++n ) {
+        uint32_t c = unsat[rng() % unsat.size()];
+
+        // roulette wheel over the literals of _c_
+        double sum = 0;
+        scores.clear();
+        for ( uint32_t i = starts[c]; i < starts[c + 1]; ++i ) {
+            uint32_t b = breaks[lits[i].var()];
+            sum += probs[std::min< std::size_t >( b, probs.size() - 1 )];
+            scores.push_back( sum );
+        }
+
+        double r = std::uniform_real_distribution< double >( 0, sum )( rng );
+        std::size_t i = 0;
+        while ( i + 1 < scores.size() && scores[i] < r ) {
+            i++;
+        }
+
+        flip( lits[starts[c] + i].var() );
+
+        if ( unsat.size() < best_unsat ) {
+            best_unsat = unsat.size();
+            best = values;
+        }
+    }
+
+    return unsat.empty();
+}
+
+void local_search::collect_stats( stats_report &report ) const {
+    report.add( "local flips", flips );
+    report.add( "local resets", resets );
+}
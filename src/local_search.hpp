@@ -0,0 +1,81 @@
+#pragma once
+#include "solver_types.hpp"
+#include "stats.hpp"
+#include <random>
+#include <vector>
+
+/*
+ * LOCAL SEARCH
+ *
+ * ProbSAT on the base clauses of a formula: a random falsified clause is
+ * picked and one of its variables flipped, chosen with probability
+ * proportional to ( eps + break )^-cb, where break is the number of clauses
+ * the flip would falsify.
+ *
+ * Clauses and occurrence lists are stored flat. Every clause keeps the
+ * number of its true literals and the xor of their variables, which is the
+ * critical variable while exactly one literal is true. The break counts of
+ * all variables are kept up to date from these on every flip, the
+ * falsified clauses are kept in a list with O(1) insertion and removal.
+ */
+struct local_search {
+
+    int vars;
+
+    /* literals of clause i are lits[starts[i]] .. lits[starts[i + 1] - 1] */
+    std::vector< lit_t > lits;
+    std::vector< uint32_t > starts;
+
+    /* clauses containing a literal, in occ[occ_starts[l.code]] .. */
+    std::vector< uint32_t > occ;
+    std::vector< uint32_t > occ_starts;
+
+    /* value of each variable */
+    std::vector< bool > values;
+
+    std::vector< uint32_t > true_count;
+    std::vector< var_t > true_xor;
+    std::vector< uint32_t > breaks;
+
+    /* falsified clauses, _unsat_pos_ is the position of a clause in _unsat_ */
+    std::vector< uint32_t > unsat;
+    std::vector< uint32_t > unsat_pos;
+
+    /* assignment with the fewest falsified clauses since reset() */
+    std::vector< bool > best;
+    std::size_t best_unsat;
+
+    /* ( eps + break )^-cb by break count */
+    std::vector< double > probs;
+    std::vector< double > scores;
+
+    std::mt19937 rng;
+
+    /* STATISTICS */
+    long long flips = 0;
+    long long resets = 0;
+
+    local_search( const formula &form, uint32_t seed );
+
+    std::size_t clause_count() const {
+        return starts.size() - 1;
+    }
+
+    bool satisfies( lit_t l ) const {
+        return values[l.var()] == l.pol();
+    }
+
+    /* starts from _phases_, unset variables get random values */
+    void reset( const std::vector< lbool > &phases );
+
+    /* flips until all clauses are satisfied ( true ) or _max_flips_ were made */
+    bool run( long long max_flips );
+
+    void collect_stats( stats_report &report ) const;
+
+private:
+
+    void flip( var_t v );
+    void make_unsat( uint32_t c );
+    void make_sat( uint32_t c );
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include "proof.hpp"
+#include "restart.hpp"
+#include <cstdint>
+#include <string>
+
+/*
+ * polarity selection of get_unassigned()
+ *
+ * TARGET         - in stable mode the phases of the longest conflict-free
+ *                  trail since the last restart, otherwise saved phases
+ * SAVED          - plain phase saving, unsaved variables are set to false
+ * SAVED_POSITIVE - plain phase saving, unsaved variables are set to true
+ */
+enum class phase_kind {
+    TARGET, SAVED, SAVED_POSITIVE
+};
+
+/*
+ * branching heuristic
+ *
+ * EVSIDS - binary heap ordered by exponentially decaying activities
+ * VMTF   - queue of the variables, bumped ones are moved to its front
+ * MIXED  - VMTF in focused mode, EVSIDS in stable mode
+ * LRB    - heap ordered by the learning rate of the variables, the share of
+ *          conflicts they took part in while assigned
+ */
+enum class branching_kind {
+    EVSIDS, VMTF, MIXED, LRB
+};
+
+inline bool parse_branching_kind( const std::string &name, branching_kind &kind ) {
+    if ( name == "evsids" ) { kind = branching_kind::EVSIDS; }
+    else if ( name == "vmtf" ) { kind = branching_kind::VMTF; }
+    else if ( name == "mixed" ) { kind = branching_kind::MIXED; }
+    else if ( name == "lrb" ) { kind = branching_kind::LRB; }
+    else { return false; }
+    return true;
+}
+
+/*
+ * local search of the solver
+ *
+ * OFF        - CDCL only
+ * INTERLEAVE - local search runs at the WALK rephases, starting from the
+ *              saved phases and leaving its best assignment in them
+ * ONLY       - local search alone, it never answers UNSAT
+ */
+enum class local_search_kind {
+    OFF, INTERLEAVE, ONLY
+};
+
+inline bool parse_local_search_kind( const std::string &name, local_search_kind &kind ) {
+    if ( name == "off" ) { kind = local_search_kind::OFF; }
+    else if ( name == "on" ) { kind = local_search_kind::INTERLEAVE; }
+    else if ( name == "only" ) { kind = local_search_kind::ONLY; }
+    else { return false; }
+    return true;
+}
+
+/*
+ * solver configuration, set from the command line
+ */
+struct solver_options {
+    restart_kind restarts = restart_kind::GLUCOSE;
+    phase_kind phases = phase_kind::TARGET;
+
+    uint32_t seed = 42;
+
+    branching_kind branching = branching_kind::EVSIDS;
+
+    /* decay factor of EVSIDS */
+    double var_decay = 0.95;
+
+    /* periodic probing and vivification between restarts */
+    bool inprocess = true;
+
+    local_search_kind local_search = local_search_kind::INTERLEAVE;
+
+    /* backjumps over more levels only undo the conflict level, 0 never */
+    int chrono_levels = 100;
+
+    /* seconds between progress lines of the search, 0 for none */
+    double report_interval = 0;
+
+    /* number of solvers run by the portfolio */
+    int threads = 1;
+
+    /* cube-and-conquer with 2^cube_depth cubes at most, 0 disables it */
+    int cube_depth = 0;
+
+    /* proof of UNSAT answers, written to _proof_path_ */
+    proof_format proof = proof_format::NONE;
+    std::string proof_path;
+};
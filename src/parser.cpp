@@ -0,0 +1,246 @@
+#include "parser.hpp"
+#include "decompress.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * byte source of the parser
+ *
+ * regular files are memory mapped and scanned in place, anything that cannot
+ * be mapped ( pipes, special files ) is streamed through a fixed buffer, so
+ * no allocation happens per token or per line. Compressed files ( gzip, xz,
+ * bzip2 ) are decoded chunk by chunk into the same buffer
+ */
+struct dimacs_input {
+
+    static constexpr std::size_t buffer_size = 1 << 20;
+
+    int fd = -1;
+
+    /* mapping of the whole file, if mmap succeeded */
+    void *mapped = MAP_FAILED;
+    std::size_t mapped_size = 0;
+
+    /* fallback buffer for streamed input */
+    std::vector< char > buffer;
+
+    /* set for compressed input */
+    std::unique_ptr< stream_decoder > decoder;
+
+    /* current window [pos, end) of unread bytes */
+    const char *pos = nullptr;
+    const char *end = nullptr;
+
+    explicit dimacs_input( const std::string &filename ) {
+        fd = ::open( filename.c_str(), O_RDONLY );
+
+        if ( fd == -1 ) {
+            throw std::runtime_error( "specified file does not exist: " + filename );
+        }
+
+        // the destructor does not run for a throwing constructor
+        try {
+            decoder = make_decoder( fd );
+        } catch ( ... ) {
+            ::close( fd );
+            throw;
+        }
+
+        struct stat st;
+        if ( !decoder && ::fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 ) {
+            mapped_size = st.st_size;
+            mapped = ::mmap( nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        }
+
+        if ( mapped != MAP_FAILED ) {
+            ::madvise( mapped, mapped_size, MADV_SEQUENTIAL );
+            pos = static_cast< const char * >( mapped );
+            end = pos + mapped_size;
+        } else {
+            buffer.resize( buffer_size );
+        }
+    }
+
+    dimacs_input( const dimacs_input & ) = delete;
+    dimacs_input& operator=( const dimacs_input & ) = delete;
+
+    ~dimacs_input() {
+        if ( mapped != MAP_FAILED ) {
+            ::munmap( mapped, mapped_size );
+        }
+        ::close( fd );
+    }
+
+    /* reads next chunk into the buffer, returns false at the end of input */
+    bool refill() {
+        if ( mapped != MAP_FAILED ) {
+            return false;
+        }
+
+        ssize_t n;
+        if ( decoder ) {
+            n = decoder->read( buffer.data(), buffer.size() );
+        } else {
+            do {
+                n = ::read( fd, buffer.data(), buffer.size() );
+            } while ( n == -1 && errno == EINTR );
+        }
+
+        if ( n < 0 ) {
+            throw std::runtime_error( "parser error, failed to read input" );
+        }
+
+        pos = buffer.data();
+        end = pos + n;
+        return n > 0;
+    }
+
+    int peek() {
+        if ( pos == end && !refill() ) {
+            return EOF;
+        }
+        return static_cast< unsigned char >( *pos );
+    }
+
+    void advance() {
+        ++pos;
+    }
+
+    static bool is_space( int c ) {
+        return c == ' ' || ( c >= '\t' && c <= '\r' );
+    }
+
+    static bool is_digit( int c ) {
+        return static_cast< unsigned >( c - '0' ) <= 9;
+    }
+
+    void skip_ws() {
+        int c = peek();
+        while ( is_space( c ) ) {
+            advance();
+            c = peek();
+        }
+    }
+
+    void skip_line() {
+        int c = peek();
+        while ( c != EOF && c != '\n' ) {
+            advance();
+            c = peek();
+        }
+    }
+
+    /* skips whitespace and comment lines */
+    void skip_ignored() {
+        skip_ws();
+        while ( peek() == 'c' ) {
+            skip_line();
+            skip_ws();
+        }
+    }
+
+    void expect( const char *word ) {
+        for ( ; *word; ++word ) {
+            if ( peek() != *word ) {
+                throw std::runtime_error( "parser error, expected p cnf line" );
+            }
+            advance();
+        }
+    }
+
+    int parse_int() {
+        bool neg = false;
+        if ( peek() == '-' ) {
+            neg = true;
+            advance();
+        }
+
+        int c = peek();
+        if ( !is_digit( c ) ) {
+            throw std::runtime_error( "parser error, expected integer" );
+        }
+
+        long long val = 0;
+        do {
+            val = val * 10 + ( c - '0' );
+            if ( val > INT_MAX ) {
+                throw std::runtime_error( "parser error, integer out of range" );
+            }
+
+            advance();
+            c = peek();
+        } while ( is_digit( c ) );
+
+        return static_cast< int >( neg ? -val : val );
+    }
+};
+
+formula parse_dimacs( const std::string &filename ) {
+
+    dimacs_input input( filename );
+
+    input.skip_ignored();
+
+    /* config line, any amount of whitespace may separate the tokens */
+    input.expect( "p" );
+    input.skip_ws();
+    input.expect( "cnf" );
+    input.skip_ws();
+    int num_vars = input.parse_int();
+    input.skip_ws();
+    int num_clauses = input.parse_int();
+
+    if ( num_vars < 0 || num_clauses < 0 ) {
+        throw std::runtime_error( "parser error, invalid p cnf line" );
+    }
+
+    formula form( num_vars );
+    form.base.reserve( num_clauses );
+
+    // 3 literals per clause is a reasonable guess for the arena size
+    form.arena.memory.reserve( num_clauses * clause::words( 3 ) );
+
+    std::vector< lit_t > curr_literals;
+
+    // start parsing clauses, these may span several lines
+    while ( true ) {
+        input.skip_ignored();
+
+        int c = input.peek();
+
+        // for some reason the satlib benchmarks terminate with %
+        if ( c == EOF || c == '%' ) { break; }
+
+        int lit = input.parse_int();
+
+        if ( lit != 0 ) {
+            if ( std::abs( lit ) > num_vars ) {
+                throw std::runtime_error( "parser error, literal " + std::to_string( lit )
+                                          + " exceeds the declared variable count" );
+            }
+            curr_literals.push_back( lit_t::from_dimacs( lit ) );
+        }
+        else {
+            // an empty clause is kept, it makes the formula trivially unsat
+            form.add_base_clause( curr_literals );
+            curr_literals.clear();
+        }
+    }
+
+    // tolerate a missing terminating 0 after the last clause
+    if ( !curr_literals.empty() ) {
+        form.add_base_clause( curr_literals );
+    }
+
+    return form;
+}
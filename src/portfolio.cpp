@@ -0,0 +1,237 @@
+#include "portfolio.hpp"
+#include <algorithm>
+#include <thread>
+
+solver_options diversify( const solver_options &base, int idx ) {
+    static const restart_kind kinds[] = { restart_kind::GLUCOSE, restart_kind::MIXED,
+                                          restart_kind::LUBY };
+    static const phase_kind phases[] = { phase_kind::TARGET, phase_kind::SAVED,
+                                         phase_kind::SAVED_POSITIVE };
+    static const double decays[] = { 0.95, 0.9, 0.97, 0.85 };
+
+    solver_options opts = base;
+    if ( idx == 0 ) {
+        return opts;
+    }
+
+    // the cycles start at the base setting, neighbouring solvers differ in
+    // restarts, groups of three in phases
+    int r = 0, p = 0;
+    while ( kinds[r] != base.restarts ) { r++; }
+    while ( phases[p] != base.phases ) { p++; }
+
+    opts.seed = base.seed + idx;
+    opts.proof = proof_format::NONE;
+    opts.report_interval = 0;
+    opts.restarts = kinds[( r + idx ) % 3];
+    opts.phases = phases[( p + idx / 3 ) % 3];
+    opts.var_decay = decays[idx % 4];
+
+    return opts;
+}
+
+portfolio::portfolio( formula form, const solver_options &opts )
+                    : cube_depth( opts.cube_depth ) {
+    int n = std::max( opts.threads, 1 );
+
+    if ( cube_depth > 0 ) {
+        solver_options cuber_opts = opts;
+        cuber_opts.proof = proof_format::NONE;
+        cuber = std::make_unique< solver >( form, cuber_opts );
+        cuber->terminate = &stop;
+        queues = std::vector< work_queue >( n );
+    }
+
+    for ( int i = 0; i < n; ++i ) {
+        configs.push_back( diversify( opts, i ) );
+    }
+
+    if ( n > 1 ) {
+        exchange = std::make_unique< clause_exchange >( n );
+    }
+
+    // the last solver takes the formula, the others copy it
+    solvers.resize( n );
+    for ( int i = 0; i < n; ++i ) {
+        solvers[i] = ( i + 1 < n ) ? std::make_unique< solver >( form, configs[i] )
+                                   : std::make_unique< solver >( std::move( form ), configs[i] );
+        solvers[i]->terminate = &stop;
+        solvers[i]->exchange = exchange.get();
+        solvers[i]->exchange_id = i;
+    }
+}
+
+template < typename Fn >
+void portfolio::run_all( Fn fn ) {
+    if ( solvers.size() == 1 ) {
+        fn( 0 );
+        return;
+    }
+
+    std::vector< std::thread > threads;
+    for ( std::size_t i = 0; i < solvers.size(); ++i ) {
+        threads.emplace_back( fn, i );
+    }
+
+    for ( auto &t : threads ) {
+        t.join();
+    }
+}
+
+lbool portfolio::solve() {
+    if ( cube_depth > 0 ) {
+        return solve_cubes();
+    }
+
+    std::vector< lbool > results( solvers.size() );
+
+    run_all( [&]( int i ) {
+        results[i] = solvers[i]->solve();
+
+        int none = -1;
+        if ( results[i] && winner.compare_exchange_strong( none, i ) ) {
+            stop = true;
+        }
+    } );
+
+    // interrupted before any solver finished
+    if ( winner < 0 ) {
+        winner = 0;
+        return std::nullopt;
+    }
+
+    return results[winner];
+}
+
+int portfolio::take_cube( int i ) {
+    {
+        std::lock_guard guard( queues[i].lock );
+        if ( !queues[i].cubes.empty() ) {
+            int c = queues[i].cubes.front();
+            queues[i].cubes.pop_front();
+            return c;
+        }
+    }
+
+    // steal from the back, the cubes furthest from what the owner works on
+    for ( std::size_t k = 1; k < queues.size(); ++k ) {
+        work_queue &q = queues[( i + k ) % queues.size()];
+        std::lock_guard guard( q.lock );
+        if ( !q.cubes.empty() ) {
+            int c = q.cubes.back();
+            q.cubes.pop_back();
+            return c;
+        }
+    }
+
+    return -1;
+}
+
+bool portfolio::pruned( const std::vector< lit_t > &cube ) {
+    std::vector< lit_t > sorted = cube;
+    std::sort( sorted.begin(), sorted.end() );
+
+    std::lock_guard guard( refuted_lock );
+    for ( const auto &core : refuted ) {
+        if ( std::includes( sorted.begin(), sorted.end(), core.begin(), core.end() ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+lbool portfolio::conquer( int i ) {
+    solver &s = *solvers[i];
+    const auto &cubes = generator->cubes;
+
+    while ( !stop ) {
+        int c = take_cube( i );
+        if ( c < 0 ) {
+            break;
+        }
+
+        if ( pruned( cubes[c] ) ) {
+            pruned_cubes++;
+            continue;
+        }
+
+        lbool res = s.solve( cubes[c] );
+        if ( !res ) {
+            break;
+        }
+
+        solved_cubes++;
+
+        // a model, or the formula is UNSAT regardless of the cube
+        if ( *res || s.failed_assumptions.empty() ) {
+            return res;
+        }
+
+        std::vector< lit_t > core = s.failed_assumptions;
+        std::sort( core.begin(), core.end() );
+
+        std::lock_guard guard( refuted_lock );
+        refuted.push_back( std::move( core ) );
+    }
+
+    return std::nullopt;
+}
+
+lbool portfolio::solve_cubes() {
+    generator = std::make_unique< cube_generator >( *cuber, cube_depth );
+
+    bool generated = generator->generate();
+    if ( interrupted ) {
+        winner = 0;
+        return std::nullopt;
+    }
+
+    if ( !generated ) {
+        winner = 0;
+        return false;
+    }
+
+    const auto &cubes = generator->cubes;
+    for ( std::size_t c = 0; c < cubes.size(); ++c ) {
+        queues[c * queues.size() / cubes.size()].cubes.push_back( c );
+    }
+
+    std::vector< lbool > results( solvers.size() );
+
+    run_all( [&]( int i ) {
+        results[i] = conquer( i );
+
+        int none = -1;
+        if ( results[i] && winner.compare_exchange_strong( none, i ) ) {
+            stop = true;
+        }
+    } );
+
+    // every cube refuted or pruned, unless interrupted
+    if ( winner < 0 ) {
+        winner = 0;
+        if ( interrupted ) {
+            return std::nullopt;
+        }
+        return false;
+    }
+
+    return results[winner];
+}
+
+void portfolio::collect_stats( stats_report &report ) {
+    if ( solvers.size() > 1 && !interrupted ) {
+        const solver_options &o = configs[winner];
+        report.add( "portfolio winner", (long long) winner );
+        report.add( "portfolio size", (long long) solvers.size() );
+        report.add( "winner seed", (long long) o.seed );
+        report.add( "winner restarts", restart_kind_name( o.restarts ) );
+        report.add( "winner decay", o.var_decay );
+    }
+    if ( generator ) {
+        generator->collect_stats( report );
+        report.add( "solved cubes", solved_cubes.load() );
+        report.add( "pruned cubes", pruned_cubes.load() );
+    }
+    best().collect_stats( report );
+}
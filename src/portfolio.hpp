@@ -0,0 +1,101 @@
+#pragma once
+#include "cubes.hpp"
+#include "solver.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+ * PORTFOLIO
+ *
+ * runs several diversified solvers on copies of the same formula, each in
+ * its own thread. The first solver to finish publishes its result and stops
+ * the others through the shared _stop_ flag, which they poll once per
+ * decision.
+ *
+ * With cube_depth > 0 the solvers instead conquer the cubes of a
+ * cube_generator. Each solver starts with a contiguous block of the cubes
+ * in generation order, so siblings stay on one solver, and steals from the
+ * back of the others' queues when its own is empty. Each cube is solved
+ * under assumptions, the failed assumptions of a refuted cube prune every
+ * cube that contains them.
+ */
+
+/*
+ * configuration of the _idx_-th solver, derived only from _base_ and the
+ * index so that a run is reproducible, solver 0 uses _base_ unchanged
+ */
+solver_options diversify( const solver_options &base, int idx );
+
+struct portfolio {
+
+    std::vector< std::unique_ptr< solver > > solvers;
+    std::vector< solver_options > configs;
+
+    std::atomic< bool > stop{ false };
+
+    /* stopped by interrupt() rather than by a result */
+    std::atomic< bool > interrupted{ false };
+
+    /* learnt clause sharing, only with more than one solver */
+    std::unique_ptr< clause_exchange > exchange;
+
+    /* index of the solver whose result is reported, -1 before solve() */
+    std::atomic< int > winner{ -1 };
+
+    /* CUBE AND CONQUER */
+
+    int cube_depth;
+    std::unique_ptr< solver > cuber;
+    std::unique_ptr< cube_generator > generator;
+
+    struct work_queue {
+        std::mutex lock;
+        std::deque< int > cubes;
+    };
+
+    std::vector< work_queue > queues;
+
+    /* sorted failed assumptions of refuted cubes */
+    std::mutex refuted_lock;
+    std::vector< std::vector< lit_t > > refuted;
+
+    std::atomic< long long > solved_cubes{ 0 };
+    std::atomic< long long > pruned_cubes{ 0 };
+
+    /* next cube for solver _i_, own queue first, -1 when all are taken */
+    int take_cube( int i );
+
+    /* is the cube implied UNSAT by an already refuted one */
+    bool pruned( const std::vector< lit_t > &cube );
+
+    /* solves cubes until none are left or the formula is decided */
+    lbool conquer( int i );
+
+    lbool solve_cubes();
+
+    portfolio( formula form, const solver_options &opts );
+
+    /* nullopt if interrupted */
+    lbool solve();
+
+    /* stops all solvers, safe to call from a signal handler */
+    void interrupt() {
+        interrupted = true;
+        stop = true;
+    }
+
+    /* runs _fn_( i ) for every solver, in parallel with more than one */
+    template < typename Fn >
+    void run_all( Fn fn );
+
+    /* the solver that finished first */
+    solver &best() {
+        return *solvers[winner];
+    }
+
+    /* the winner and cube counters, then the statistics of the winner */
+    void collect_stats( stats_report &report );
+};
@@ -0,0 +1,555 @@
+#include "preprocess.hpp"
+#include <algorithm>
+#include <chrono>
+
+preprocessor::preprocessor( formula &form ) : vars( form.var_count ),
+                                              occs( 2 * form.var_count + 2 ),
+                                              vals( 2 * form.var_count + 2 ),
+                                              marks( 2 * form.var_count + 2 ) {
+    extension.eliminated.resize( vars + 1 );
+
+    if ( form.empty_clause ) {
+        unsat = true;
+    }
+
+    for ( cref_t ref : form.base ) {
+        const clause &c = form[ref];
+        add_clause( std::vector< lit_t >( c.begin(), c.end() ) );
+    }
+
+    clauses_before = clauses.size();
+}
+
+uint64_t preprocessor::signature( const std::vector< lit_t > &lits ) {
+    uint64_t sig = 0;
+    for ( lit_t l : lits ) {
+        sig |= uint64_t( 1 ) << ( l.var() & 63 );
+    }
+    return sig;
+}
+
+void preprocessor::next_stamp() {
+    if ( ++stamp == 0 ) {
+        std::fill( marks.begin(), marks.end(), 0 );
+        stamp = 1;
+    }
+}
+
+void preprocessor::add_clause( std::vector< lit_t > lits ) {
+    // sorted and without duplicates, drop tautologies
+    std::sort( lits.begin(), lits.end() );
+    lits.erase( std::unique( lits.begin(), lits.end() ), lits.end() );
+    for ( std::size_t i = 1; i < lits.size(); ++i ) {
+        if ( lits[i] == -lits[i - 1] ) {
+            return;
+        }
+    }
+
+    if ( lits.empty() ) {
+        unsat = true;
+        return;
+    }
+
+    int i = clauses.size();
+    for ( lit_t l : lits ) {
+        occs[l.code].push_back( i );
+    }
+
+    sigs.push_back( signature( lits ) );
+    removed.push_back( false );
+    queued.push_back( true );
+    queue.push_back( i );
+
+    if ( lits.size() == 1 ) {
+        units.push_back( lits[0] );
+    }
+
+    clauses.push_back( std::move( lits ) );
+}
+
+void preprocessor::remove_clause( int i ) {
+    removed[i] = true;
+}
+
+void preprocessor::strengthen( int i, lit_t l ) {
+    std::vector< lit_t > &c = clauses[i];
+    std::erase( c, l );
+    std::erase( occs[l.code], i );
+    sigs[i] = signature( c );
+    strengthened++;
+
+    if ( c.empty() ) {
+        unsat = true;
+        return;
+    }
+
+    if ( c.size() == 1 ) {
+        units.push_back( c[0] );
+    }
+
+    if ( !queued[i] ) {
+        queued[i] = true;
+        queue.push_back( i );
+    }
+}
+
+void preprocessor::assign( lit_t l ) {
+    vals[l.code] = 1;
+    vals[( -l ).code] = -1;
+    fixed++;
+}
+
+bool preprocessor::propagate() {
+    while ( !unsat && units_head < units.size() ) {
+        lit_t l = units[units_head++];
+
+        if ( vals[l.code] > 0 ) {
+            continue;
+        }
+        if ( vals[l.code] < 0 ) {
+            unsat = true;
+            break;
+        }
+
+        assign( l );
+
+        for ( int i : occs[l.code] ) {
+            if ( !removed[i] ) {
+                remove_clause( i );
+            }
+        }
+
+        std::vector< int > falsified = occs[( -l ).code];
+        for ( int i : falsified ) {
+            if ( !removed[i] ) {
+                strengthen( i, -l );
+            }
+        }
+    }
+
+    return !unsat;
+}
+
+std::vector< int > &preprocessor::live_occs( lit_t l ) {
+    std::vector< int > &list = occs[l.code];
+    std::erase_if( list, [&]( int i ) { return removed[i]; } );
+    return list;
+}
+
+void preprocessor::backward_subsume( int i ) {
+    const std::vector< lit_t > &c = clauses[i];
+
+    // candidates contain the variable of _c_ with the fewest occurrences
+    lit_t best = c[0];
+    for ( lit_t l : c ) {
+        if ( occs[l.code].size() + occs[( -l ).code].size()
+             < occs[best.code].size() + occs[( -best ).code].size() ) {
+            best = l;
+        }
+    }
+
+    next_stamp();
+    for ( lit_t l : c ) {
+        marks[l.code] = stamp;
+    }
+
+    for ( lit_t occ : { best, -best } ) {
+        std::vector< int > candidates = occs[occ.code];
+
+        for ( int j : candidates ) {
+            if ( j == i || removed[j] || removed[i] || clauses[j].size() < c.size()
+                 || ( sigs[i] & ~sigs[j] ) != 0 ) {
+                continue;
+            }
+
+            /* every literal of _c_ has to occur in _d_, one of them may occur
+             * negated, then _d_ is strengthened instead of removed */
+            const std::vector< lit_t > &d = clauses[j];
+            steps += d.size();
+
+            std::size_t found = 0;
+            lit_t flipped;
+            for ( lit_t l : d ) {
+                if ( marks[l.code] == stamp ) {
+                    found++;
+                }
+                else if ( marks[( -l ).code] == stamp && !flipped.defined() ) {
+                    flipped = l;
+                    found++;
+                }
+            }
+
+            if ( found < c.size() ) {
+                continue;
+            }
+
+            if ( !flipped.defined() ) {
+                remove_clause( j );
+                subsumed++;
+            } else {
+                strengthen( j, flipped );
+                if ( unsat ) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+bool preprocessor::forward_subsumed( const std::vector< lit_t > &lits ) {
+    uint64_t sig = signature( lits );
+
+    next_stamp();
+    for ( lit_t l : lits ) {
+        marks[l.code] = stamp;
+    }
+
+    for ( lit_t l : lits ) {
+        for ( int j : occs[l.code] ) {
+            const std::vector< lit_t > &d = clauses[j];
+            if ( removed[j] || d.size() > lits.size() || ( sigs[j] & ~sig ) != 0 ) {
+                continue;
+            }
+
+            steps += d.size();
+            if ( std::all_of( d.begin(), d.end(),
+                              [&]( lit_t x ) { return marks[x.code] == stamp; } ) ) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool preprocessor::subsume_queued() {
+    while ( !queue.empty() && !unsat && !out_of_steps() ) {
+        int i = queue.back();
+        queue.pop_back();
+        queued[i] = false;
+
+        if ( !removed[i] ) {
+            backward_subsume( i );
+        }
+
+        if ( !propagate() ) {
+            return false;
+        }
+    }
+
+    return !unsat;
+}
+
+bool preprocessor::resolve( const std::vector< lit_t > &c, const std::vector< lit_t > &d,
+                            var_t v, std::vector< lit_t > &out ) {
+    out.clear();
+    next_stamp();
+
+    for ( lit_t l : c ) {
+        if ( l.var() != v ) {
+            marks[l.code] = stamp;
+            out.push_back( l );
+        }
+    }
+
+    steps += c.size() + d.size();
+    for ( lit_t l : d ) {
+        if ( l.var() == v || marks[l.code] == stamp ) {
+            continue;
+        }
+        if ( marks[( -l ).code] == stamp ) {
+            return false;
+        }
+        out.push_back( l );
+    }
+
+    return true;
+}
+
+bool preprocessor::find_equivalences() {
+    std::size_t nodes = 2 * vars + 2;
+
+    // -a implies b and -b implies a for every binary clause ( a b )
+    std::vector< std::vector< lit_t > > edges( nodes );
+    for ( std::size_t i = 0; i < clauses.size(); ++i ) {
+        const std::vector< lit_t > &c = clauses[i];
+        if ( !removed[i] && c.size() == 2 ) {
+            edges[( -c[0] ).code].push_back( c[1] );
+            edges[( -c[1] ).code].push_back( c[0] );
+            steps += 2;
+        }
+    }
+
+    repr.resize( nodes );
+    for ( std::size_t code = 2; code < nodes; ++code ) {
+        repr[code].code = code;
+    }
+
+    // discovery index and lowest reachable index of each literal, 0 is unvisited
+    std::vector< uint32_t > index( nodes ), low( nodes );
+    std::vector< bool > on_stack( nodes );
+    std::vector< lit_t > component;
+    std::vector< std::pair< lit_t, std::size_t > > dfs;
+    uint32_t next_index = 1;
+
+    for ( std::size_t root = 2; root < nodes; ++root ) {
+        if ( index[root] || edges[root].empty() ) {
+            continue;
+        }
+
+        lit_t r;
+        r.code = root;
+        dfs.assign( 1, { r, 0 } );
+        index[root] = low[root] = next_index++;
+        component.push_back( r );
+        on_stack[root] = true;
+
+        while ( !dfs.empty() ) {
+            auto &[l, i] = dfs.back();
+
+            if ( i < edges[l.code].size() ) {
+                lit_t next = edges[l.code][i++];
+                if ( !index[next.code] ) {
+                    index[next.code] = low[next.code] = next_index++;
+                    component.push_back( next );
+                    on_stack[next.code] = true;
+                    dfs.push_back( { next, 0 } );
+                }
+                else if ( on_stack[next.code] ) {
+                    low[l.code] = std::min( low[l.code], index[next.code] );
+                }
+                continue;
+            }
+
+            lit_t done = l;
+            dfs.pop_back();
+            if ( !dfs.empty() ) {
+                lit_t parent = dfs.back().first;
+                low[parent.code] = std::min( low[parent.code], low[done.code] );
+            }
+
+            if ( low[done.code] != index[done.code] ) {
+                continue;
+            }
+
+            /* _done_ is the root of a component, its literals are on top of
+             * the stack. The literal of the smallest variable represents it,
+             * the mirrored component then gets the negation as representative */
+            std::size_t start = component.size();
+            lit_t best = done;
+            do {
+                start--;
+                on_stack[component[start].code] = false;
+                if ( component[start].var() < best.var() ) {
+                    best = component[start];
+                }
+            } while ( component[start] != done );
+
+            for ( std::size_t k = start; k < component.size(); ++k ) {
+                lit_t x = component[k];
+                if ( x.var() == best.var() && x != best ) {
+                    return false;
+                }
+                repr[x.code] = best;
+            }
+            component.resize( start );
+        }
+    }
+
+    return true;
+}
+
+bool preprocessor::substitute_equivalences() {
+    if ( !find_equivalences() ) {
+        unsat = true;
+        return false;
+    }
+
+    std::vector< var_t > replaced;
+    for ( var_t v = 1; v <= vars; ++v ) {
+        lit_t x( v, true );
+        if ( repr[x.code] != x && vals[x.code] == 0 ) {
+            replaced.push_back( v );
+        }
+    }
+
+    if ( replaced.empty() ) {
+        return true;
+    }
+
+    /* clauses with replaced literals are added again in terms of the
+     * representatives, the clauses making up the equivalences become
+     * tautologies and disappear */
+    std::size_t count = clauses.size();
+    for ( std::size_t i = 0; i < count; ++i ) {
+        if ( removed[i] ) {
+            continue;
+        }
+
+        std::vector< lit_t > &c = clauses[i];
+        if ( std::none_of( c.begin(), c.end(), [&]( lit_t l ) { return repr[l.code] != l; } ) ) {
+            continue;
+        }
+
+        std::vector< lit_t > lits;
+        for ( lit_t l : c ) {
+            lits.push_back( repr[l.code] );
+        }
+        steps += c.size();
+
+        remove_clause( i );
+        add_clause( std::move( lits ) );
+    }
+
+    // the model sets each replaced variable like its representative
+    for ( var_t v : replaced ) {
+        lit_t x( v, true );
+        lit_t r = repr[x.code];
+        lit_t pos_clause[] = { x, -r };
+        lit_t neg_clause[] = { -x, r };
+        extension.push( x, pos_clause );
+        extension.push( -x, neg_clause );
+        extension.eliminated[v] = true;
+        substituted++;
+    }
+
+    return propagate() && subsume_queued();
+}
+
+bool preprocessor::try_eliminate( var_t v ) {
+    lit_t pos_lit( v, true ), neg_lit( v, false );
+    if ( vals[pos_lit.code] != 0 || extension.is_eliminated( v ) ) {
+        return false;
+    }
+
+    std::vector< int > pos = live_occs( pos_lit );
+    std::vector< int > neg = live_occs( neg_lit );
+
+    if ( (int) ( pos.size() + neg.size() ) > max_occurrences ) {
+        return false;
+    }
+
+    // the resolvents may not outnumber the clauses they replace
+    std::vector< std::vector< lit_t > > res;
+    std::vector< lit_t > r;
+    std::size_t limit = pos.size() + neg.size();
+
+    for ( int i : pos ) {
+        for ( int j : neg ) {
+            if ( !resolve( clauses[i], clauses[j], v, r ) ) {
+                continue;
+            }
+            if ( res.size() == limit || (int) r.size() > max_resolvent_size ) {
+                return false;
+            }
+            res.push_back( r );
+        }
+    }
+
+    for ( int i : pos ) {
+        extension.push( pos_lit, clauses[i] );
+        remove_clause( i );
+    }
+
+    for ( int i : neg ) {
+        extension.push( neg_lit, clauses[i] );
+        remove_clause( i );
+    }
+
+    extension.eliminated[v] = true;
+    eliminated++;
+
+    for ( auto &lits : res ) {
+        if ( !forward_subsumed( lits ) ) {
+            resolvents++;
+            add_clause( std::move( lits ) );
+        }
+    }
+
+    return true;
+}
+
+void preprocessor::eliminate_vars() {
+    std::vector< var_t > order;
+    std::vector< long long > cost( vars + 1 );
+
+    // a few rounds, the eliminations of a round enable new ones
+    for ( int round = 0; round < 3; ++round ) {
+        order.clear();
+        for ( var_t v = 1; v <= vars; ++v ) {
+            if ( vals[2 * v] == 0 && !extension.is_eliminated( v ) ) {
+                cost[v] = (long long) occs[2 * v].size() * occs[2 * v + 1].size();
+                order.push_back( v );
+            }
+        }
+
+        // cheapest first
+        std::stable_sort( order.begin(), order.end(),
+                          [&]( var_t a, var_t b ) { return cost[a] < cost[b]; } );
+
+        long long before = eliminated;
+        for ( var_t v : order ) {
+            if ( out_of_steps() ) {
+                return;
+            }
+
+            if ( try_eliminate( v ) && ( !propagate() || !subsume_queued() ) ) {
+                return;
+            }
+        }
+
+        if ( eliminated == before ) {
+            break;
+        }
+    }
+}
+
+formula preprocessor::run() {
+    auto start = std::chrono::steady_clock::now();
+
+    if ( propagate() && subsume_queued() && substitute_equivalences() ) {
+        eliminate_vars();
+    }
+
+    seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    return build();
+}
+
+formula preprocessor::build() {
+    formula form( vars );
+
+    if ( unsat ) {
+        std::vector< lit_t > empty;
+        form.add_base_clause( empty );
+        return form;
+    }
+
+    for ( std::size_t i = 0; i < clauses.size(); ++i ) {
+        if ( !removed[i] ) {
+            form.add_base_clause( clauses[i] );
+        }
+    }
+
+    // fixed variables stay as unit clauses
+    for ( var_t v = 1; v <= vars; ++v ) {
+        if ( vals[2 * v] != 0 ) {
+            std::vector< lit_t > unit{ lit_t( v, vals[2 * v] > 0 ) };
+            form.add_base_clause( unit );
+        }
+    }
+
+    form.extension = std::move( extension );
+    return form;
+}
+
+void preprocessor::collect_stats( stats_report &report ) const {
+    report.add( "clauses before", (long long) clauses_before );
+    report.add( "clauses after", (long long) std::count( removed.begin(), removed.end(), false ) );
+    report.add( "preprocess time", seconds );
+    report.add( "eliminated vars", eliminated );
+    report.add( "resolvents", resolvents );
+    report.add( "fixed vars", fixed );
+    report.add( "substituted vars", substituted );
+    report.add( "subsumed clauses", subsumed );
+    report.add( "strengthened", strengthened );
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "solver_types.hpp"
+#include "stats.hpp"
+#include <atomic>
+#include <vector>
+
+/*
+ * PREPROCESSING
+ *
+ * simplifies the formula before it is handed to the solver:
+ *  - unit propagation
+ *  - subsumption, every clause removes the clauses it subsumes ( backward ),
+ *    resolvents are dropped if an existing clause subsumes them ( forward )
+ *  - self-subsuming resolution, C + l and D + -l where C is a subset of D
+ *    strengthen D to D without -l
+ *  - equivalent literal substitution, the strongly connected components
+ *    of the implication graph of the binary clauses are equivalent
+ *    literals, each is replaced by one representative
+ *  - bounded variable elimination, a variable is replaced by all
+ *    resolvents of its clauses if there are no more of them than clauses,
+ *    none longer than _max_resolvent_size_
+ *
+ * Subset checks are filtered by 64 bit signatures of the variables of a
+ * clause. The clauses of eliminated variables go to the model extension of
+ * the resulting formula.
+ */
+struct preprocessor {
+
+    int vars;
+
+    std::vector< std::vector< lit_t > > clauses;
+    std::vector< uint64_t > sigs;
+    std::vector< bool > removed;
+
+    /* clause indices by literal, may contain removed clauses */
+    std::vector< std::vector< int > > occs;
+
+    /* level 0 assignment, by literal */
+    std::vector< int8_t > vals;
+    std::vector< lit_t > units;
+    std::size_t units_head = 0;
+
+    /* clauses to run backward subsumption with */
+    std::vector< int > queue;
+    std::vector< bool > queued;
+
+    /* literal marks of subset and tautology checks */
+    std::vector< uint32_t > marks;
+    uint32_t stamp = 0;
+
+    model_extension extension;
+
+    bool unsat = false;
+
+    int max_resolvent_size = 20;
+
+    /* variables with more occurrences are not eliminated */
+    int max_occurrences = 32;
+
+    /* literal visits allowed, keeps preprocessing of huge formulas short */
+    long long steps = 0;
+    long long step_limit = 300000000;
+
+    /* stops the simplification early when set, the result stays sound */
+    const std::atomic< bool > *terminate = nullptr;
+
+    /* STATISTICS */
+    std::size_t clauses_before = 0;
+    long long subsumed = 0;
+    long long strengthened = 0;
+    long long eliminated = 0;
+    long long resolvents = 0;
+    long long fixed = 0;
+    long long substituted = 0;
+    double seconds = 0;
+
+    explicit preprocessor( formula &form );
+
+    /* simplified formula, with the model extension of the eliminated vars */
+    formula run();
+
+    void collect_stats( stats_report &report ) const;
+
+private:
+
+    static uint64_t signature( const std::vector< lit_t > &lits );
+
+    bool out_of_steps() const {
+        return steps > step_limit
+               || ( terminate && terminate->load( std::memory_order_relaxed ) );
+    }
+
+    void next_stamp();
+
+    void add_clause( std::vector< lit_t > lits );
+    void remove_clause( int i );
+    void strengthen( int i, lit_t l );
+
+    void assign( lit_t l );
+    bool propagate();
+
+    /* removes clauses subsumed by and strengthens clauses with clause _i_ */
+    void backward_subsume( int i );
+    bool forward_subsumed( const std::vector< lit_t > &lits );
+    bool subsume_queued();
+
+    /* live occurrences of _l_, dropping removed clauses from the list */
+    std::vector< int > &live_occs( lit_t l );
+
+    /* resolvent of _c_ and _d_ on _v_ in _out_, false if tautological */
+    bool resolve( const std::vector< lit_t > &c, const std::vector< lit_t > &d, var_t v,
+                  std::vector< lit_t > &out );
+
+    /* representative of each literal by code, the literal itself if it
+     * is not substituted, filled by find_equivalences() */
+    std::vector< lit_t > repr;
+
+    /* Tarjan's algorithm on the binary implication graph, false if some
+     * literal is equivalent to its negation */
+    bool find_equivalences();
+    bool substitute_equivalences();
+
+    bool try_eliminate( var_t v );
+    void eliminate_vars();
+
+    formula build();
+};
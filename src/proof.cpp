@@ -0,0 +1,117 @@
+#include "proof.hpp"
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+proof_writer::proof_writer( const std::string &path, proof_format format ) : format( format ) {
+    fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 ) {
+        throw std::runtime_error( "failed to open proof file " + path );
+    }
+
+    buffer.reserve( buffer_size + 4096 );
+    pending.reserve( buffer_size + 4096 );
+    writer = std::thread( &proof_writer::write_loop, this );
+}
+
+proof_writer::~proof_writer() {
+    close();
+}
+
+bool proof_writer::close() {
+    if ( fd < 0 ) {
+        return !failed;
+    }
+
+    flush();
+    {
+        std::lock_guard guard( lock );
+        done = true;
+    }
+    cv.notify_all();
+    writer.join();
+
+    if ( ::close( fd ) < 0 ) {
+        failed = true;
+    }
+    fd = -1;
+
+    return !failed;
+}
+
+void proof_writer::flush() {
+    std::unique_lock guard( lock );
+    cv.wait( guard, [&] { return !has_pending; } );
+
+    std::swap( buffer, pending );
+    has_pending = true;
+    guard.unlock();
+    cv.notify_all();
+}
+
+void proof_writer::write_loop() {
+    std::vector< char > writing;
+    writing.reserve( buffer_size + 4096 );
+
+    while ( true ) {
+        {
+            std::unique_lock guard( lock );
+            cv.wait( guard, [&] { return has_pending || done; } );
+            if ( !has_pending ) {
+                return;
+            }
+
+            std::swap( writing, pending );
+            has_pending = false;
+        }
+        cv.notify_all();
+
+        // after a failure the rest is dropped, the proof is incomplete anyway
+        std::size_t off = 0;
+        while ( off < writing.size() && !failed ) {
+            ssize_t n = ::write( fd, writing.data() + off, writing.size() - off );
+            if ( n < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( n <= 0 ) {
+                failed = true;
+                break;
+            }
+            off += n;
+        }
+        writing.clear();
+    }
+}
+
+void proof_writer::add( std::span< const lit_t > lits ) {
+    put( 'a' );
+    put_lits( lits );
+    end_step();
+}
+
+void proof_writer::remove( std::span< const lit_t > lits ) {
+    put( 'd' );
+    put_lits( lits );
+    end_step();
+}
+
+void proof_writer::add( uint64_t id, std::span< const lit_t > lits,
+                        std::span< const uint64_t > hints ) {
+    put( 'a' );
+    put_number( 2 * id );
+    put_lits( lits );
+    for ( uint64_t h : hints ) {
+        put_number( 2 * h );
+    }
+    put( 0 );
+    end_step();
+}
+
+void proof_writer::remove( uint64_t id ) {
+    put( 'd' );
+    put_number( 2 * id );
+    put( 0 );
+    end_step();
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "solver_types.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * PROOFS
+ *
+ * DRAT - clause additions and deletions, in the binary format of drat-trim:
+ *        'a' <lits> 0 and 'd' <lits> 0, literals encoded as 2 * var + sign
+ * LRAT - additions carry their id and the ids of the clauses that make the
+ *        added clause RUP, in the order they become unit:
+ *        'a' <id> <lits> 0 <hint ids> 0 and 'd' <ids> 0, ids encoded as 2 * id
+ *
+ * Numbers are written as 7-bit little endian varints. Input clauses have
+ * ids 1..m in the order of the DIMACS file.
+ */
+
+enum class proof_format {
+    NONE, DRAT, LRAT
+};
+
+inline bool parse_proof_format( const std::string &name, proof_format &format ) {
+    if ( name == "drat" ) { format = proof_format::DRAT; }
+    else if ( name == "lrat" ) { format = proof_format::LRAT; }
+    else { return false; }
+    return true;
+}
+
+/*
+ * fills a large buffer that is handed to a background thread for writing
+ * once full, the solver only waits when the previous buffer is not written
+ * yet
+ */
+struct proof_writer {
+
+    static constexpr std::size_t buffer_size = 1 << 22;
+
+    proof_format format;
+    int fd;
+
+    std::vector< char > buffer;
+
+    /* buffer waiting for the writer thread */
+    std::vector< char > pending;
+    bool has_pending = false;
+    bool done = false;
+
+    /* a write failed, the proof on disk is incomplete */
+    std::atomic< bool > failed{ false };
+
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread writer;
+
+    proof_writer( const std::string &path, proof_format format );
+    ~proof_writer();
+
+    proof_writer( const proof_writer & ) = delete;
+    proof_writer& operator=( const proof_writer & ) = delete;
+
+    bool lrat() const {
+        return format == proof_format::LRAT;
+    }
+
+    /* DRAT */
+    void add( std::span< const lit_t > lits );
+    void remove( std::span< const lit_t > lits );
+
+    /* LRAT */
+    void add( uint64_t id, std::span< const lit_t > lits, std::span< const uint64_t > hints );
+    void remove( uint64_t id );
+
+    void flush();
+
+    /* writes out everything and closes the file, returns false if the
+     * proof is incomplete. Called by the destructor if not before */
+    bool close();
+
+private:
+
+    void put( char c ) {
+        buffer.push_back( c );
+    }
+
+    void put_number( uint64_t x ) {
+        while ( x > 127 ) {
+            buffer.push_back( char( ( x & 127 ) | 128 ) );
+            x >>= 7;
+        }
+        buffer.push_back( char( x ) );
+    }
+
+    void put_lits( std::span< const lit_t > lits ) {
+        for ( lit_t l : lits ) {
+            put_number( l.code );
+        }
+        put( 0 );
+    }
+
+    void end_step() {
+        if ( buffer.size() >= buffer_size ) {
+            flush();
+        }
+    }
+
+    void write_loop();
+};
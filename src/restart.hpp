@@ -0,0 +1,197 @@
+#pragma once
+#include "stats.hpp"
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+/*
+ * RESTART POLICIES
+ *
+ * LUBY    - restart after luby( i ) * unit conflicts
+ * GLUCOSE - restart when the recent LBDs are worse than the long term
+ *           average, postponed when the trail is much larger than usual
+ * MIXED   - alternates between a focused mode ( glucose restarts ) and
+ *           a stable mode ( luby restarts with a large unit ), the phases
+ *           grow geometrically
+ */
+
+enum class restart_kind {
+    LUBY, GLUCOSE, MIXED
+};
+
+inline bool parse_restart_kind( const std::string &name, restart_kind &kind ) {
+    if ( name == "luby" ) { kind = restart_kind::LUBY; }
+    else if ( name == "glucose" ) { kind = restart_kind::GLUCOSE; }
+    else if ( name == "mixed" ) { kind = restart_kind::MIXED; }
+    else { return false; }
+    return true;
+}
+
+inline const char *restart_kind_name( restart_kind kind ) {
+    switch ( kind ) {
+        case restart_kind::LUBY: return "luby";
+        case restart_kind::GLUCOSE: return "glucose";
+        default: return "mixed";
+    }
+}
+
+/* finite subsequences of the luby sequence: 1, 1, 2, 1, 1, 2, 4, ... */
+inline double luby( double y, long x ) {
+    long size, seq;
+    for ( size = 1, seq = 0; size < x + 1; seq++, size = 2 * size + 1 ) { }
+
+    while ( size - 1 != x ) {
+        size = ( size - 1 ) >> 1;
+        seq--;
+        x = x % size;
+    }
+
+    return std::pow( y, seq );
+}
+
+/* exponential moving average with bias correction of the first values */
+struct ema {
+    double biased = 0;
+    double value = 0;
+    double alpha;
+    double exp = 1;
+
+    explicit ema( double alpha ) : alpha( alpha ) { }
+
+    void update( double y ) {
+        biased += alpha * ( y - biased );
+        exp *= 1 - alpha;
+        value = biased / ( 1 - exp );
+    }
+};
+
+struct restart_policy {
+
+    restart_kind kind;
+
+    /* mode of MIXED, LUBY is always stable and GLUCOSE always focused */
+    bool stable_mode;
+
+    /* conflicts since last restart */
+    long conflicts = 0;
+
+    /* LUBY */
+    int luby_unit = 100;
+    int stable_luby_unit = 1024;
+    long luby_index = 0;
+
+    /* GLUCOSE */
+    ema fast_lbd{ 1.0 / 32 };
+    ema slow_lbd{ 1.0 / 10000 };
+    ema trail_size{ 1.0 / 5000 };
+
+    /* restart if fast_lbd * margin > slow_lbd, i.e. the recent LBDs are about
+     * 10% worse than the long term average */
+    double margin = 0.9;
+
+    /* postpone the restart if the trail is this much larger than average */
+    double block_margin = 1.4;
+
+    /* minimal number of conflicts between glucose restarts */
+    int min_conflicts = 50;
+
+    /* MIXED */
+    long mode_conflicts = 0;
+    long mode_limit = 2000;
+
+    /* STATISTICS */
+    long long restarts = 0;
+    long long luby_restarts = 0;
+    long long glucose_restarts = 0;
+    long long blocked = 0;
+    long long mode_switches = 0;
+    long long stable_conflicts = 0;
+    long long focused_conflicts = 0;
+
+    /* decision levels kept by partial restarts */
+    long long reused_levels = 0;
+    long long reused_restarts = 0;
+
+    explicit restart_policy( restart_kind kind ) : kind( kind ),
+                                                   stable_mode( kind == restart_kind::LUBY ) { }
+
+    bool stable() const {
+        return stable_mode;
+    }
+
+    long luby_limit() const {
+        int unit = ( kind == restart_kind::MIXED ) ? stable_luby_unit : luby_unit;
+        return luby( 2, luby_index ) * unit;
+    }
+
+    /* called for every learnt clause */
+    void on_conflict( int lbd, std::size_t trail ) {
+        conflicts++;
+        mode_conflicts++;
+        ( stable_mode ? stable_conflicts : focused_conflicts )++;
+
+        if ( stable_mode ) {
+            return;
+        }
+
+        fast_lbd.update( lbd );
+        slow_lbd.update( lbd );
+
+        // trail much longer than usual, the solver may be close to a model
+        if ( focused_conflicts > 10000 && conflicts > min_conflicts
+             && trail > block_margin * trail_size.value ) {
+            conflicts = 0;
+            blocked++;
+        }
+
+        trail_size.update( trail );
+    }
+
+    bool should_restart() {
+        if ( kind == restart_kind::MIXED && mode_conflicts > mode_limit ) {
+            switch_mode();
+            return true;
+        }
+
+        if ( stable_mode ) {
+            return conflicts >= luby_limit();
+        }
+
+        return conflicts >= min_conflicts && fast_lbd.value * margin > slow_lbd.value;
+    }
+
+    void on_restart() {
+        restarts++;
+        if ( stable_mode ) {
+            luby_restarts++;
+            luby_index++;
+        } else {
+            glucose_restarts++;
+        }
+        conflicts = 0;
+    }
+
+    void on_reuse( int levels ) {
+        reused_levels += levels;
+        reused_restarts += levels > 0;
+    }
+
+    void switch_mode() {
+        stable_mode = !stable_mode;
+        mode_conflicts = 0;
+        mode_switches++;
+        mode_limit *= 2;
+    }
+
+    void collect_stats( stats_report &report ) const {
+        report.add( "restart policy", restart_kind_name( kind ) );
+        report.add( "luby restarts", luby_restarts );
+        report.add( "glucose restarts", glucose_restarts );
+        report.add( "blocked restarts", blocked );
+        report.add( "mode switches", mode_switches );
+        report.add( "stable conflicts", stable_conflicts );
+        report.add( "focused conflicts", focused_conflicts );
+        report.add( "reused levels", reused_levels );
+        report.add( "reused restarts", reused_restarts );
+    }
+};
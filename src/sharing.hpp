@@ -0,0 +1,152 @@
+#pragma once
+#include "solver_types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+ * CLAUSE SHARING
+ *
+ * every solver of a portfolio exports its short low LBD learnt clauses into
+ * its own ring buffer, the other solvers read all rings at level 0. A ring
+ * has a single writer and any number of readers, each reader keeps its own
+ * position, so nothing is ever locked or waited for. The writer overwrites
+ * the oldest entries, readers that fall behind by more than the capacity
+ * lose clauses, which only costs the learning, not correctness.
+ *
+ * Slots are guarded by a sequence number ( seqlock ), odd while the writer
+ * fills the slot, 2 * ( position + 1 ) once the entry at _position_ is
+ * complete. A reader copies the slot and accepts the copy only if the
+ * sequence number did not change meanwhile.
+ */
+
+struct clause_ring {
+
+    static constexpr std::size_t capacity = 1 << 12;
+    static constexpr std::size_t max_lits = 16;
+
+    struct slot {
+        std::atomic< uint64_t > seq{ 0 };
+        std::atomic< uint32_t > size{ 0 };
+        std::atomic< uint32_t > lbd{ 0 };
+        std::array< std::atomic< uint32_t >, max_lits > lits;
+    };
+
+    std::unique_ptr< slot[] > slots;
+
+    /* number of entries written so far, on its own cache line */
+    alignas( 64 ) std::atomic< uint64_t > head{ 0 };
+
+    clause_ring() : slots( new slot[capacity] ) { }
+
+    /* writer only, _lits_ has at most _max_lits_ literals */
+    void push( std::span< const lit_t > lits, int lbd ) {
+        uint64_t pos = head.load( std::memory_order_relaxed );
+        slot &s = slots[pos % capacity];
+
+        s.seq.store( 2 * pos + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        s.size.store( lits.size(), std::memory_order_relaxed );
+        s.lbd.store( lbd, std::memory_order_relaxed );
+        for ( std::size_t i = 0; i < lits.size(); ++i ) {
+            s.lits[i].store( lits[i].code, std::memory_order_relaxed );
+        }
+
+        s.seq.store( 2 * pos + 2, std::memory_order_release );
+        head.store( pos + 1, std::memory_order_release );
+    }
+
+    /*
+     * reads the entry at _pos_ into _out_ and advances _pos_, skips entries
+     * that were already overwritten. Returns false when there is nothing new.
+     */
+    bool pop( uint64_t &pos, std::vector< lit_t > &out, int &lbd ) const {
+        while ( true ) {
+            uint64_t end = head.load( std::memory_order_acquire );
+            if ( pos >= end ) {
+                return false;
+            }
+
+            if ( end - pos > capacity ) {
+                pos = end - capacity;
+            }
+
+            const slot &s = slots[pos % capacity];
+            uint64_t seq = s.seq.load( std::memory_order_acquire );
+            uint64_t expected = 2 * pos + 2;
+            pos++;
+
+            if ( seq != expected ) {
+                continue;
+            }
+
+            // a torn size is rejected below, but must not overrun the slot
+            uint32_t size = std::min< uint32_t >( s.size.load( std::memory_order_relaxed ),
+                                                  max_lits );
+            lbd = s.lbd.load( std::memory_order_relaxed );
+            out.resize( size );
+            for ( uint32_t i = 0; i < size; ++i ) {
+                out[i].code = s.lits[i].load( std::memory_order_relaxed );
+            }
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if ( s.seq.load( std::memory_order_relaxed ) == expected ) {
+                return true;
+            }
+        }
+    }
+};
+
+struct clause_exchange {
+
+    /* clauses up to this LBD ( and _max_lits_ literals ) are exported */
+    int max_lbd = 3;
+
+    std::vector< clause_ring > rings;
+
+    /* cursors[consumer][producer], touched only by the consumer thread */
+    std::vector< std::vector< uint64_t > > cursors;
+
+    explicit clause_exchange( int solvers ) : rings( solvers ),
+                                              cursors( solvers,
+                                                       std::vector< uint64_t >( solvers ) ) { }
+
+    bool accepts( std::size_t size, int lbd ) const {
+        return size <= clause_ring::max_lits && ( lbd <= max_lbd || size == 1 );
+    }
+
+    void export_clause( int id, std::span< const lit_t > lits, int lbd ) {
+        rings[id].push( lits, lbd );
+    }
+
+    /* are there clauses of other solvers _id_ did not read yet */
+    bool pending( int id ) const {
+        for ( std::size_t p = 0; p < rings.size(); ++p ) {
+            if ( (int) p != id
+                 && cursors[id][p] < rings[p].head.load( std::memory_order_relaxed ) ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* calls _fn_( lits, lbd ) for every new clause of the other solvers */
+    template < typename Fn >
+    void import_clauses( int id, std::vector< lit_t > &buffer, Fn fn ) {
+        int lbd;
+        for ( std::size_t p = 0; p < rings.size(); ++p ) {
+            if ( (int) p == id ) {
+                continue;
+            }
+
+            while ( rings[p].pop( cursors[id][p], buffer, lbd ) ) {
+                fn( std::span< const lit_t >( buffer ), lbd );
+            }
+        }
+    }
+};
@@ -1,38 +1,77 @@
 #include "solver.hpp"
 #include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
 
-void solver::initialize_clause( clause& cl, int clref ) {
+void solver::initialize_clause( cref_t clref ) {
 
-    lit_t l1 = cl.data[0];
-    lit_t l2 = cl.data[ ( cl.size() > 1 ) ];
+    clause& cl = form[clref];
+    lit_t l1 = cl[0];
 
-    // add new entry to watches if the clause was learnt
-    if ( clref >= watches.size() ) {
-        watches.push_back( { l1, l2 } );
-    } else {
-        watches[clref] = { l1, l2 };
-    }
-
-    // unit clause, setup trail for first UP
-    if ( cl.status == clause::UNIT ) {
-        if ( !asgn.lit_unassigned(l1) && !asgn.satisfies_literal(l1) ) {
+    // unit clause ( or asserting learnt clause ), setup trail for first UP
+    if ( cl.learnt || cl.size() == 1 ) {
+        if ( asgn.falsifies_literal( l1 ) ) {
+            conflict_idx = clref;
             unsat = true;
             return;
         }
 
-        assign( l1.var(), l1.pol() );
-        reasons.push_back( clref );
-        cl.reason_index = reasons.size() - 1;
+        if ( cl.size() == 2 ) {
+            assign( l1, reason_t::binary( cl[1], clref ) );
+        } else {
+            assign( l1, reason_t::clause( clref ) );
+            cl.reason = 1;
+        }
+    }
+
+    // unit clauses stay assigned at level 0, no need to watch them
+    if ( cl.size() == 1 ) {
+        return;
+    }
+
+    attach_clause( clref );
+}
+
+void solver::attach_clause( cref_t clref ) {
+
+    clause& cl = form[clref];
+    lit_t l1 = cl[0];
+
+    if ( cl.size() == 2 ) {
+        bin_occurs[l1].push_back( { clref, cl[1] } );
+        bin_occurs[cl[1]].push_back( { clref, l1 } );
+        return;
     }
 
-    // init occurs vecs
-    occurs[l1].push_back( clref );
-    occurs[l2].push_back( clref );
+    // init occurs vecs, each watch uses the other one as its blocker
+    occurs[l1].push_back( { clref, cl[1] } );
+    occurs[cl[1]].push_back( { clref, l1 } );
 }
 
 void solver::initialize_structures() {
-    for ( std::size_t i = 0; i < form.clause_count; i++ ){
-        initialize_clause( form[i], i );
+
+    // learning rates start at zero, all variables are still equal in the heap
+    if ( branching == branching_kind::LRB ) {
+        std::fill( heap.priorities.begin(), heap.priorities.end(), 0.0 );
+    }
+
+    // eliminated variables occur in no clause and are never decided
+    for ( var_t v = 1; v <= (var_t) form.var_count; ++v ) {
+        if ( form.extension.is_eliminated( v ) ) {
+            heap.remove( v );
+            queue.remove( v );
+        }
+    }
+
+    // empty clause, the formula is trivially unsatisfiable
+    if ( form.empty_clause ) {
+        unsat = true;
+        return;
+    }
+
+    for ( cref_t clref : form.base ) {
+        initialize_clause( clref );
 
         if ( unsat ) {
             return;
@@ -46,8 +85,11 @@ std::vector< bool > solver::get_model() {
     std::vector< bool > res( asgn.vars_count );
 
     for ( int var = 1; var <= asgn.vars_count; ++var ) {
-        res[var-1] = asgn.satisfies_literal( var );
+        res[var-1] = asgn.satisfies_literal( lit_t( var, true ) );
     }
+
+    // values of variables eliminated by preprocessing
+    form.extension.extend( res );
     return res;
 }
 
@@ -65,23 +107,66 @@ std::string solver::get_model_string() {
     return model_str;        
 }
 
-void solver::output_model( const std::string &filename ) {
-    std::string str = get_model_string();
-    std::ofstream out( filename, std::ios::out );
-    out << str;
+void solver::collect_stats( stats_report &report ) const {
+    auto per = []( double n, double d ) { return d > 0 ? n / d : 0.0; };
+
+    report.add( "search time", search_seconds );
+    report.add( "decisions", decided );
+    report.add( "decision rate", per( decided, search_seconds ) );
+    report.add( "propagations", propagations );
+    report.add( "conflicts", conflicts );
+    report.add( "conflict rate", per( conflicts, search_seconds ) );
+    report.add( "restarts", restarts.restarts );
+    report.add( "learnt clauses", learnt_clauses );
+    report.add( "average lbd", per( lbd_sum, learnt_clauses ) );
+    report.add( "reductions", reductions );
+    report.add( "deleted clauses", deleted_clauses );
+    report.add( "kept clauses", (long long) form.learnt.size() );
+    report.add( "watch visits", watch_visits );
+    report.add( "visits per prop", per( watch_visits, propagations ) );
+    report.add( "propagate time", propagate_seconds );
+    report.add( "analyze time", analyze_seconds );
+    report.add( "reduce time", reduce_seconds );
+    report.add( "restart time", restart_seconds );
+
+    if ( exchange ) {
+        report.add( "exported clauses", exported_clauses );
+        report.add( "imported clauses", imported_clauses );
+    }
+    if ( inprocess_rounds > 0 ) {
+        report.add( "inprocess rounds", inprocess_rounds );
+        report.add( "inprocess time", inprocess_seconds );
+        report.add( "inprocess props", inprocess_propagations );
+        report.add( "failed literals", failed_literals );
+        report.add( "vivify tried", vivify_tried );
+        report.add( "vivify shortened", vivify_shortened );
+        report.add( "vivify deleted", vivify_deleted );
+    }
+    if ( chrono_backtracks > 0 ) {
+        report.add( "chrono backtracks", chrono_backtracks );
+        report.add( "missed implied", missed_implications );
+    }
+    report.add( "rephases", rephases );
+    report.add( "walks", walks );
+    if ( sls ) {
+        sls->collect_stats( report );
+    }
+    restarts.collect_stats( report );
 }
 
-void solver::log_clause( const clause& c, const std::string &title, auto idx ) {
+void solver::log_clause( const clause& c, const std::string &title ) {
     if ( !log.enabled() ) return;
     
     log.log() << "   " << title << " clause - {";
-    for ( lit_t x : c.data ) {
-        log.log() << x << ", "; 
+    for ( lit_t x : c ) {
+        log.log() << x.to_dimacs() << ", ";
     }
 
     log.log() << "}";
-    auto& x = watches[idx];
-    log.log() << "Watches - " << x.first << ", " << x.second << "\n";
+    if ( c.size() > 1 ) {
+        log.log() << "Watches - " << c[0].to_dimacs() << ", " << c[1].to_dimacs();
+    }
+    log.log() << "\n";
 
 }
 
@@ -90,8 +175,8 @@ void solver::log_solver_state( const std::string &title, bool all_clauses=false
 
 
     if ( all_clauses )
-        for ( int i = 0; i < form.clause_count; i++ ) {
-            log_clause( form[i] , "Clause " + std::to_string(i), i );
+        for ( cref_t ref : form.base ) {
+            log_clause( form[ref] , "Clause " + std::to_string(ref) );
         }
 
     log.log() << title << "\n";
@@ -113,14 +198,14 @@ void solver::log_solver_state( const std::string &title, bool all_clauses=false
     log.log() << "index: " << index << "\n";
     log.log() << "TRAIL:\n";
     log.log() << "[ ";
-    for ( auto x : trail ) { log.log() << x << ", ";}
+    for ( auto x : trail ) { log.log() << x.to_dimacs() << ", ";}
     log.log() << " ]\n\n";
 
     log.log() << "ASGN:\n";
     log.log() << "[ ";
-    for ( int i = 1; i < asgn.asgn.size(); i++ ) { 
+    for ( int i = 1; i <= asgn.vars_count; i++ ) {
         if ( asgn.var_unassigned( i ) ) { log.log() << " none ; "; }
-        else { log.log() << asgn.satisfies_literal( i ) << " ; "; }
+        else { log.log() << asgn.satisfies_literal( lit_t( i, true ) ) << " ; "; }
     }
     log.log() << " ]\n\n";
 
@@ -136,7 +221,11 @@ void solver::log_solver_state( const std::string &title, bool all_clauses=false
 
     log.log() << "REASONS:\n";
     log.log() << "[ ";
-    for ( auto x : reasons ) { log.log() << x << ", "; }
+    for ( auto x : trail ) {
+        reason_t r = reasons[x.var()];
+        if ( r.is_binary() ) { log.log() << "bin " << r.other.to_dimacs() << ", "; }
+        else { log.log() << r.cref << ", "; }
+    }
     log.log() << " ]\n\n";
 
     // log.log() << "OCCURS:\n";
@@ -150,88 +239,501 @@ void solver::log_solver_state( const std::string &title, bool all_clauses=false
 }
 
 void solver::decide( var_t x, bool v ) {
-    assign(x, v);
-    levels[x]++;
-    decisions.push_back(trail.size() - 1);
-    reasons.push_back(-1);
+    decisions.push_back( trail.size() );
+    assign( lit_t( x, v ), reason_t() );
 }
 
-void solver::assign( var_t x, bool v ) {
-    asgn.assign( x, v );
-    lit_t l = ( v ) ? x : -x;
-    trail.push_back(l);
-    levels[x] = decisions.size();
+void solver::assign( lit_t l, reason_t reason ) {
+    asgn.assign( l );
+    trail.push_back( l );
+    levels[l.var()] = out_of_order && !reason.is_decision() ? reason_level( l, reason )
+                                                            : decisions.size();
+    reasons[l.var()] = reason;
+
+    if ( branching == branching_kind::LRB ) {
+        assigned_at[l.var()] = conflicts;
+        participated[l.var()] = 0;
+        reasoned[l.var()] = 0;
+    }
 }
 
 void solver::unassign( var_t x ){
     asgn.unassign( x );
 
-    // potentially return x back to the evsids heap
-    heap.insert( x );
+    if ( branching == branching_kind::LRB ) {
+        update_learning_rate( x );
+    }
+
+    // potentially return x back to the evsids heap, before the VMTF search
+    if ( branching != branching_kind::VMTF ) {
+        heap.insert( x );
+    }
+    if ( branching != branching_kind::EVSIDS ) {
+        queue.on_unassign( x );
+    }
 }
 
 void solver::decay_var_priority() {
-    inc *= var_decay;
+    if ( branching == branching_kind::LRB ) {
+        lrb_step = std::max( 0.06, lrb_step - 1e-6 );
+        return;
+    }
+
+    if ( !uses_vmtf() ) {
+        inc *= var_decay;
+        return;
+    }
+
+    // no decay in VMTF, the bumped variables move to the end in their order
+    std::sort( vmtf_bumped.begin(), vmtf_bumped.end(), [&]( var_t a, var_t b ) {
+        return queue.stamps[a] < queue.stamps[b];
+    } );
+
+    for ( var_t v : vmtf_bumped ) {
+        queue.bump( v, asgn.var_unassigned( v ) );
+    }
+    vmtf_bumped.clear();
 }
 
 void solver::increase_var_priority( var_t v ) {
-    heap.increase_priority( v, inc );
+    if ( branching == branching_kind::LRB ) {
+        participated[v]++;
+    } else if ( uses_vmtf() ) {
+        vmtf_bumped.push_back( v );
+    } else {
+        heap.increase_priority( v, inc );
+    }
 }
 
-void solver::restart() {
+void solver::update_learning_rate( var_t v ) {
+    long long interval = conflicts - assigned_at[v];
+    if ( interval <= 0 ) {
+        return;
+    }
 
-    change_restart_limit();
-    conflicts = 0;
-    index = decisions[0];
-    decisions.clear();
+    double rate = double( participated[v] + reasoned[v] ) / interval;
+    heap.priorities[v] = ( 1 - lrb_step ) * heap.priorities[v] + lrb_step * rate;
+    heap.update( v );
+}
 
-    for ( int k = index ; k < trail.size(); ++k ) {
-        unassign( trail[k].var() );
+void solver::bump_reason_side( std::span< const lit_t > learnt ) {
+    // variables in the reasons of the learnt literals, but not analyzed
+    auto bump = [&]( lit_t l ) {
+        var_t v = l.var();
+        if ( !seen[v] && levels[v] > 0 ) {
+            seen[v] = SEEN_SOURCE;
+            analyze_toclear.push_back( l );
+            reasoned[v]++;
+        }
+    };
+
+    for ( lit_t l : learnt ) {
+        reason_t r = reasons[l.var()];
+        if ( r.is_binary() ) {
+            bump( r.other );
+        } else if ( r.is_clause() ) {
+            for ( lit_t o : form[r.cref] ) {
+                if ( o.var() != l.var() ) {
+                    bump( o );
+                }
+            }
+        }
+    }
+}
+
+bool solver::ranks_above( var_t v, var_t u ) const {
+    if ( uses_vmtf() ) {
+        return queue.stamps[v] > queue.stamps[u];
+    }
+    return heap.priorities[v] > heap.priorities[u];
+}
 
-        if ( reasons[k] != -1 )
-            form[reasons[k]].reason_index = -1;
+void solver::backtrack( int level ) {
+    if ( level >= current_level() ) {
+        return;
     }
 
-    trail.resize( index );
-    reasons.resize( index );
+    /* all entries in trail from decisions[level] on are removed, except
+     * those of lower levels left there by chronological backtracking */
+    std::size_t next_level = decisions[level];
+    std::size_t kept = next_level;
+
+    for ( std::size_t k = next_level ; k < trail.size(); ++k ) {
+        var_t v = trail[k].var();
+        if ( levels[v] <= level ) {
+            trail[kept++] = trail[k];
+            continue;
+        }
+
+        unassign( v );
+
+        if ( reasons[v].is_clause() )
+            form[reasons[v].cref].reason = 0;
+    }
+
+    decisions.resize( level );
+    trail.resize( kept );
+
+    if ( level < assumed_level ) {
+        assumed_level = -1;
+    }
+    if ( level == 0 ) {
+        out_of_order = false;
+    }
+
+    // the kept literals are propagated again
+    index = std::min( index, next_level );
 }
 
-/* iff all assigned then 0 */
-var_t solver::get_unassigned( bool& polarity ) {
-    var_t v_max = 0;
+int solver::reuse_trail_level() {
+    var_t next = 0;
 
-    do {
-        v_max = heap.extract_max();
+    if ( uses_vmtf() ) {
+        next = queue.next_unassigned( asgn );
+    } else {
+        // drop assigned variables from the top of the heap to find the next decision
+        while ( !heap.heap.empty() && !asgn.var_unassigned( heap.heap[0] ) ) {
+            heap.extract_max();
+        }
+        next = heap.heap.empty() ? 0 : heap.heap[0];
+    }
+
+    if ( next == 0 ) {
+        return current_level();
     }
-    while ( !asgn.var_unassigned( v_max ) );
 
+    int level = 0;
+    while ( level < current_level() && ranks_above( trail[decisions[level]].var(), next ) ) {
+        level++;
+    }
 
-    bool pol = false;
-    lbool saved = asgn.saved_phase(v_max);
-    if ( saved ) {
-        switch ( asgn.decision_count / 100 ) {
-            case 0:
-                pol = *saved;
-                asgn.decision_count -= 3;
-                break;
-            case 1:
-                pol = !*saved;
-                break;
-            case 3:
-                pol = rand_pol();
-                break;
-            default:
-                break;
+    return level;
+}
+
+bool solver::restart() {
+    scoped_timer timer( restart_seconds );
+
+    restarts.on_restart();
+
+    /* the decisions that would be made again right after the restart are
+     * kept, together with their propagations. Shared clauses are only
+     * imported and inprocessing only runs at level 0, so a full restart is
+     * made when either is due */
+    bool inprocess_due = inprocessing && conflicts >= next_inprocess;
+    bool rephase_due = conflicts >= next_rephase;
+    int level = ( inprocess_due || rephase_due
+                  || ( exchange && exchange->pending( exchange_id ) ) )
+                ? 0 : reuse_trail_level();
+    restarts.on_reuse( level );
+
+    backtrack( level );
+    asgn.target_size = 0;
+
+    if ( inprocess_due && !inprocess() ) {
+        return false;
+    }
+
+    if ( rephase_due ) {
+        rephase();
+    }
+
+    return true;
+}
+
+void solver::save_trail_phases() {
+    // the current level conflicts, the trail below it does not
+    std::size_t size = decisions.back();
+
+    if ( size > asgn.target_size ) {
+        asgn.target_size = size;
+        for ( std::size_t i = 0; i < size; ++i ) {
+            asgn.target_phase[trail[i].var()] = trail[i].pol();
         }
     }
 
-    asgn.decision_count += 4;
+    if ( size > asgn.best_size ) {
+        asgn.best_size = size;
+        for ( std::size_t i = 0; i < size; ++i ) {
+            asgn.best_phase[trail[i].var()] = trail[i].pol();
+        }
+    }
+}
+
+void solver::rephase() {
+    static const rephase_kind schedule[] = {
+        rephase_kind::BEST, rephase_kind::WALK, rephase_kind::ORIGINAL,
+        rephase_kind::BEST, rephase_kind::WALK, rephase_kind::INVERTED,
+        rephase_kind::BEST, rephase_kind::WALK, rephase_kind::RANDOM
+    };
+
+    rephase_kind kind = schedule[rephases++ % std::size( schedule )];
+    follow_phases = false;
+
+    switch ( kind ) {
+        case rephase_kind::ORIGINAL:
+        case rephase_kind::INVERTED:
+            for ( var_t v = 1; v <= (var_t) form.var_count; ++v ) {
+                asgn.last_phase[v] = original_phase() == ( kind == rephase_kind::ORIGINAL );
+            }
+            break;
+        case rephase_kind::RANDOM:
+            for ( var_t v = 1; v <= (var_t) form.var_count; ++v ) {
+                asgn.last_phase[v] = rand_pol();
+            }
+            break;
+        case rephase_kind::BEST:
+        case rephase_kind::WALK:
+            for ( var_t v = 1; v <= (var_t) form.var_count; ++v ) {
+                if ( asgn.best_phase[v] ) {
+                    asgn.last_phase[v] = asgn.best_phase[v];
+                }
+            }
+
+            // a walk goes on from the best phases with local search
+            if ( kind == rephase_kind::WALK
+                 && local_search_mode == local_search_kind::INTERLEAVE ) {
+                long long search = propagations - inprocess_propagations;
+                local_search_round( ( search - walk_searched ) * local_search_effort );
+                walk_searched = search;
+                walks++;
+            }
+            break;
+    }
+
+    // the next target starts from the new phases
+    asgn.target_phase = asgn.last_phase;
+    asgn.target_size = 0;
+    asgn.best_size = 0;
+
+    rephase_interval += rephase_inc;
+    next_rephase = conflicts + rephase_interval;
+}
 
-    if ( asgn.decision_count >= asgn.period ) {
-        asgn.decision_count = 0;
+void solver::build_local_search() {
+    if ( !sls || sls->clause_count() != form.base.size() || sls->vars != form.var_count ) {
+        sls = std::make_unique< local_search >( form, rng() );
     }
+}
+
+bool solver::local_search_round( long long flips ) {
+    build_local_search();
+
+    sls->reset( asgn.last_phase );
+    bool sat = sls->run( flips );
+
+    for ( var_t v = 1; v <= (var_t) form.var_count; ++v ) {
+        asgn.last_phase[v] = bool( sls->best[v] );
+    }
+
+    follow_phases = sat;
+    return sat;
+}
+
+bool solver::inprocess() {
+    assert( current_level() == 0 );
+    auto start = std::chrono::steady_clock::now();
+
+    long long before = propagations;
+    long long search = propagations - inprocess_propagations;
+    long long budget = ( search - searched ) * inprocess_effort;
+
+    // probing finds units the vivification profits from
+    bool ok = probe_literals( before + budget / 2 ) && vivify_clauses( before + budget );
+
+    inprocess_rounds++;
+    inprocess_propagations += propagations - before;
+    searched = search;
+    inprocess_seconds += std::chrono::duration< double >( std::chrono::steady_clock::now()
+                                                          - start ).count();
+
+    inprocess_interval += inprocess_inc;
+    next_inprocess = conflicts + inprocess_interval;
+    return ok;
+}
+
+bool solver::probe_literals( long long limit ) {
+    for ( int n = 0; n < form.var_count && propagations < limit; ++n ) {
+        probe_next = probe_next % form.var_count + 1;
+        var_t v = probe_next;
+
+        for ( bool pol : { true, false } ) {
+            lit_t l( v, pol );
 
-    polarity = pol;
+            // only literals in binary clauses imply anything right away
+            if ( !asgn.lit_unassigned( l ) || bin_occurs[-l].empty() ) {
+                continue;
+            }
+
+            decide( v, pol );
+            if ( unit_propagation() ) {
+                backtrack( 0 );
+                continue;
+            }
+
+            // the conflict is at level 1, the learnt clause is a unit
+            auto [learnt, level, lbd] = analyze_conflict();
+            decay_var_priority();
+            backjump( 0, std::move( learnt ), lbd );
+            failed_literals++;
+
+            if ( !unit_propagation() ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool solver::vivify_clauses( long long limit ) {
+    std::vector< cref_t > candidates;
+    for ( cref_t ref : form.learnt ) {
+        const clause &c = form[ref];
+        if ( c.type != clause::LOCAL && !c.vivified && !c.reason && c.size() > 2 ) {
+            candidates.push_back( ref );
+        }
+    }
+
+    // most useful first
+    std::stable_sort( candidates.begin(), candidates.end(), [&]( cref_t l, cref_t r ) {
+        return form[l].lbd < form[r].lbd;
+    } );
+
+    bool ok = true;
+    for ( cref_t ref : candidates ) {
+        if ( propagations >= limit || interrupted() ) {
+            break;
+        }
+
+        // units found meanwhile may have made it a reason
+        if ( form[ref].reason ) {
+            continue;
+        }
+
+        if ( !vivify_clause( ref ) ) {
+            ok = false;
+            break;
+        }
+    }
+
+    std::erase_if( form.learnt, [&]( cref_t ref ) { return form[ref].deleted; } );
+    return ok;
+}
+
+bool solver::vivify_clause( cref_t ref ) {
+    clause &c = form[ref];
+    c.vivified = 1;
+    vivify_tried++;
+
+    // satisfied at level 0, not needed anymore
+    for ( lit_t l : c ) {
+        if ( asgn.satisfies_literal( l ) && levels[l.var()] == 0 ) {
+            detach_clause( ref );
+            if ( proof ) {
+                proof_delete( ref );
+            }
+            form.arena.free( ref );
+            form.clause_count--;
+            vivify_deleted++;
+            return true;
+        }
+    }
+
+    /* the clause itself must not propagate, its literals are falsified one
+     * by one until that implies a conflict or one of the remaining literals */
+    detach_clause( ref );
+
+    vivify_lits.clear();
+    cref_t reason = cref_undef;
+    for ( lit_t l : c ) {
+        if ( asgn.falsifies_literal( l ) ) {
+            continue;
+        }
+
+        vivify_lits.push_back( l );
+        if ( asgn.satisfies_literal( l ) ) {
+            reason = reasons[l.var()].cref;
+            break;
+        }
+
+        decide( l.var(), !l.pol() );
+        if ( !unit_propagation() ) {
+            reason = conflict_idx;
+            break;
+        }
+    }
+
+    if ( vivify_lits.size() == c.size() ) {
+        backtrack( 0 );
+        attach_clause( ref );
+        return true;
+    }
+
+    // all literals are false, the clause itself is the conflict
+    if ( reason == cref_undef ) {
+        reason = ref;
+    }
+
+    assert( !vivify_lits.empty() );
+    if ( proof && proof->lrat() ) {
+        lrat_chain( vivify_lits, reason );
+    }
+
+    int lbd = std::min< int >( c.lbd, vivify_lits.size() );
+    backtrack( 0 );
+
+    cref_t shortened;
+    if ( vivify_lits.size() == 1 ) {
+        shortened = add_learnt_clause( vivify_lits, 1 );
+    } else {
+        shortened = form.add_learnt_clause( vivify_lits, lbd, conflicts );
+        form[shortened].vivified = 1;
+        attach_clause( shortened );
+    }
+
+    if ( proof ) {
+        proof_add( shortened );
+        proof_delete( ref );
+    }
+
+    form.arena.free( ref );
+    form.clause_count--;
+    vivify_shortened++;
+
+    return vivify_lits.size() > 1 || unit_propagation();
+}
+
+void solver::detach_clause( cref_t ref ) {
+    const clause &c = form[ref];
+    for ( lit_t l : { c[0], c[1] } ) {
+        std::erase_if( occurs[l], [&]( const watch &w ) { return w.cref == ref; } );
+    }
+}
+
+/* iff all assigned then 0 */
+var_t solver::get_unassigned( bool& polarity ) {
+    var_t v_max = 0;
+
+    if ( uses_vmtf() ) {
+        v_max = queue.next_unassigned( asgn );
+    } else {
+        do {
+            v_max = heap.extract_max();
+        }
+        while ( !asgn.var_unassigned( v_max ) );
+    }
+
+
+    lbool phase = asgn.saved_phase( v_max );
+
+    /* in stable mode the target phase wins over the saved one, unless the
+     * saved ones are a model */
+    if ( phases == phase_kind::TARGET && restarts.stable() && !follow_phases
+         && asgn.target_phase[v_max] ) {
+        phase = asgn.target_phase[v_max];
+    }
+
+    polarity = phase ? *phase : original_phase();
     return v_max;
 }
 
@@ -242,10 +744,24 @@ bool solver::unit_propagation() {
     while ( index < trail.size() ) {
 
         lit_t lit = trail[index++];
+        propagations++;
         lit.flip();
 
-        // get indices of clauses where -lit occurs
-        auto& clause_indices = occurs[lit];
+        // binary clauses first, the implied literal is stored in the list
+        watch_visits += bin_occurs[lit].size();
+        for ( const watch &w : bin_occurs[lit] ) {
+            int8_t val = asgn.value( w.blocker );
+            if ( val == 0 ) {
+                assign( w.blocker, reason_t::binary( lit, w.cref ) );
+            }
+            else if ( val < 0 ) {
+                conflict_idx = w.cref;
+                return false;
+            }
+        }
+
+        // get watches of clauses where -lit occurs
+        auto& watches = occurs[lit];
 
         /* track two indices 
          * i - currently investigated index of occurs[-lit]
@@ -254,34 +770,33 @@ bool solver::unit_propagation() {
          * i.e. swap and move elements to avoid erasing at the end
          */
         int j = 0;
-        for ( int i = 0; i < clause_indices.size(); ++i ) {
+        for ( int i = 0; i < watches.size(); ++i ) {
+
+            watch w = watches[i];
 
-            int clause_idx = clause_indices[i];
-            auto [l1, l2] = watches[clause_idx];
-            if ( (l1 != lit && l2 != lit) || !form.is_valid_clause( clause_idx ) ) {
+            // clause is satisfied by the blocker, no need to look at it
+            if ( asgn.satisfies_literal( w.blocker ) ) {
+                watches[j++] = w;
                 continue;
             }
 
-            bool swapped = false;
-            
-            if ( lit != l1 ) {
-                l2 = l1;
-                l1 = lit;
-                swapped = true;
-            }
+            cref_t clause_idx = w.cref;
+            clause& c = form[clause_idx];
 
-            // try to avoid moving watch
-            if ( asgn.satisfies_literal( l2 ) ) {
-                clause_indices[j++] = clause_idx;
-                continue;
+            assert( !c.deleted && ( c[0] == lit || c[1] == lit ) );
+
+            // make sure the false literal is the first watch
+            if ( c[0] != lit ) {
+                std::swap( c[0], c[1] );
             }
 
-            clause& c = form[clause_idx];
+            lit_t l2 = c[1];
+            watch kept = { clause_idx, l2 };
 
-            if ( swapped ) {
-                c.data[1] = c.data[0];
-                c.data[0] = lit;
-                std::swap( watches[clause_idx].first, watches[clause_idx].second );
+            // try to avoid moving watch
+            if ( l2 != w.blocker && asgn.satisfies_literal( l2 ) ) {
+                watches[j++] = kept;
+                continue;
             }
 
             /*
@@ -291,24 +806,15 @@ bool solver::unit_propagation() {
             bool found = false;
 
             // find unassigned literal
-            for ( std::size_t k = 2; k < c.data.size(); ++k ) {
-
-                lit_t l = c.data[k];
+            for ( std::size_t k = 2; k < c.size(); ++k ) {
 
-                // get ls assignment ( nullopt / bool )
-                lbool& asgn_l = asgn[l.var()];
-
-                // handle duplicit snd watch, TODO: can save this by preprocessing
-                if (l == l2) {
-                    continue;
-                }
+                lit_t l = c[k];
 
                 // if the literal is unassigned or satisfied
-                if ( !asgn_l || ( asgn_l == l.pol() ) ) {
+                if ( !asgn.falsifies_literal( l ) ) {
                     // w1 = k;
-                    std::swap( c.data[0], c.data[k] );
-                    watches[clause_idx].first = c.data[0];
-                    occurs[l].push_back( clause_idx );
+                    std::swap( c[0], c[k] );
+                    occurs[l].push_back( kept );
                     found = true;
                     break;
                 }
@@ -321,14 +827,12 @@ bool solver::unit_propagation() {
 
             /* did not find new index for w1, the watch will remain in effect
              * swap the index entry and increment j*/
-            clause_indices[j++] = clause_idx;
-            // lit_t l = c.data[w2];
+            watches[j++] = kept;
 
             // if second watch is unassigned, unit prop
             if ( asgn.lit_unassigned( l2 ) ) {
-                assign( l2.var(), l2.pol() );
-                reasons.push_back( clause_idx );
-                c.reason_index = reasons.size() - 1;
+                assign( l2, reason_t::clause( clause_idx ) );
+                c.reason = 1;
             }
 
             /* if the second watch is unsat
@@ -339,103 +843,450 @@ bool solver::unit_propagation() {
                 // save index of conflict clause
                 conflict_idx = clause_idx;
                 i++;
+                watch_visits += i;
 
-                for ( ; i < clause_indices.size(); i++ ) {
-                    clause_indices[j++] = clause_indices[i];
+                for ( ; i < watches.size(); i++ ) {
+                    watches[j++] = watches[i];
                 }
 
-                clause_indices.resize(j);
+                watches.resize(j);
                 return false;
             }
 
         }
 
         // adjust the occurs vector after watches have been moved
-        clause_indices.resize(j);
+        watch_visits += watches.size();
+        watches.resize(j);
 
     }
     return true;
 }
 
-void solver::add_base_clause(clause c) {
-    form.add_base_clause(std::move(c));
+var_t solver::new_var() {
+    reserve_vars( form.var_count + 1 );
+    return form.var_count;
+}
+
+void solver::reserve_vars( int count ) {
+    if ( count <= form.var_count ) {
+        return;
+    }
+
+    form.var_count = count;
+    asgn.grow( count );
+    // new variables rank like one bump of EVSIDS, or with no learning rate yet
+    heap.grow( count, branching == branching_kind::LRB ? 0.0 : inc );
+    queue.grow( count );
+    occurs.grow( count );
+    bin_occurs.grow( count );
+    seen.resize( count + 1 );
+    assigned_at.resize( count + 1 );
+    participated.resize( count + 1 );
+    reasoned.resize( count + 1 );
+    reasons.resize( count + 1 );
+    levels.resize( count + 1 );
+    lbd_stamps.resize( count + 1 );
+
+    if ( !unit_ids.empty() ) {
+        unit_ids.resize( count + 1 );
+        lrat_marks.resize( count + 1 );
+    }
 }
 
-void solver::add_learnt_clause(clause c, size_t clref) {
-    form.add_learnt_clause(std::move(c), clref);
+cref_t solver::add_base_clause( std::vector< lit_t > lits ) {
+    // the checker only knows the clauses of the input file
+    if ( proof ) {
+        throw std::logic_error( "clauses cannot be added while writing a proof" );
+    }
+
+    // between solve() calls, clauses are added at level 0
+    backtrack( 0 );
+
+    var_t max_var = 0;
+    for ( lit_t l : lits ) {
+        max_var = std::max( max_var, l.var() );
+    }
+    reserve_vars( max_var );
+
+    /* literals false at level 0 are dropped, the clause is skipped when it
+     * is satisfied at level 0 or contains both phases of a variable */
+    std::sort( lits.begin(), lits.end() );
+    std::size_t j = 0;
+    for ( std::size_t i = 0; i < lits.size(); ++i ) {
+        lit_t l = lits[i];
+        if ( asgn.satisfies_literal( l ) || ( i > 0 && lits[i - 1] == -l ) ) {
+            return cref_undef;
+        }
+        if ( !asgn.falsifies_literal( l ) && ( j == 0 || lits[j - 1] != l ) ) {
+            lits[j++] = l;
+        }
+    }
+    lits.resize( j );
+
+    cref_t clref = form.add_base_clause( lits );
+
+    if ( clref == cref_undef ) {
+        unsat = true;
+    } else {
+        initialize_clause( clref );
+    }
+
+    return clref;
 }
 
-void solver::backjump( int level, clause learnt ) {
+bool solver::import_clauses() {
+    assert( current_level() == 0 );
+
+    exchange->import_clauses( exchange_id, import_buffer,
+                              [&]( std::span< const lit_t > lits, int lbd ) {
+        if ( unsat ) {
+            return;
+        }
+
+        import_lits.clear();
+        for ( lit_t l : lits ) {
+            // satisfied at level 0, nothing to learn
+            if ( asgn.satisfies_literal( l ) ) {
+                return;
+            }
+            if ( !asgn.falsifies_literal( l ) ) {
+                import_lits.push_back( l );
+            }
+        }
+
+        imported_clauses++;
+
+        if ( import_lits.empty() ) {
+            unsat = true;
+        }
+        else if ( import_lits.size() == 1 ) {
+            add_learnt_clause( import_lits, 1 );
+        }
+        else {
+            // no literal is assigned, the clause is watched but not asserting
+            int size = import_lits.size();
+            attach_clause( form.add_learnt_clause( import_lits, std::min( lbd, size ),
+                                                   conflicts ) );
+        }
+    } );
+
+    return !unsat && unit_propagation();
+}
+
+cref_t solver::add_learnt_clause( const std::vector< lit_t > &lits, int lbd ) {
+    cref_t clref = form.add_learnt_clause( lits, lbd, conflicts );
+    form.inc_activity( clref );
+    initialize_clause( clref );
+    return clref;
+}
+
+void solver::reduce_db() {
+    scoped_timer timer( reduce_seconds );
+    reductions++;
+    deleted_clauses += form.forget_clauses( conflicts, proof ? &forgotten : nullptr );
+    detach_deleted();
+
+    if ( proof ) {
+        for ( cref_t ref : forgotten ) {
+            proof_delete( ref );
+        }
+    }
+
+    if ( form.arena.wasted > form.arena.size() / 5 ) {
+        collect_garbage();
+    }
+
+    reduce_interval += reduce_inc;
+    next_reduce = conflicts + reduce_interval;
+}
+
+void solver::detach_deleted() {
+    for ( auto& watches : occurs.data ) {
+        std::erase_if( watches, [&]( const watch &w ) { return form[w.cref].deleted; } );
+    }
+}
+
+void solver::collect_garbage() {
+    clause_arena to( form.arena.size() - form.arena.wasted );
+
+    // watch lists only reference live clauses
+    for ( auto& watches : occurs.data ) {
+        for ( watch& w : watches ) {
+            form.arena.reloc( w.cref, to );
+        }
+    }
+
+    for ( auto& watches : bin_occurs.data ) {
+        for ( watch& w : watches ) {
+            form.arena.reloc( w.cref, to );
+        }
+    }
+
+    // reasons are never deleted, binary ones keep their reference for proofs
+    for ( lit_t l : trail ) {
+        reason_t& r = reasons[l.var()];
+        if ( r.cref != cref_undef ) {
+            form.arena.reloc( r.cref, to );
+        }
+    }
+
+    // the conflict of a probe may have been reduced since
+    if ( conflict_idx != cref_undef ) {
+        if ( form[conflict_idx].deleted ) {
+            conflict_idx = cref_undef;
+        } else {
+            form.arena.reloc( conflict_idx, to );
+        }
+    }
+
+    // LRAT ids move along with the clauses
+    std::vector< uint64_t > ids( clause_ids.empty() ? 0 : form.arena.size() );
+
+    for ( auto *refs : { &form.base, &form.learnt } ) {
+        for ( cref_t& ref : *refs ) {
+            cref_t old = ref;
+            form.arena.reloc( ref, to );
+            if ( !clause_ids.empty() ) {
+                ids[ref] = clause_ids[old];
+            }
+        }
+    }
+
+    clause_ids = std::move( ids );
+    form.arena = std::move( to );
+}
+
+void solver::backjump( int level, std::vector< lit_t > learnt, int lbd ) {
 
     assert( level < decisions.size() );
 
-    /* index of next decision level that is to be removed, i.e. all entries in
-     * trail after decisions[level] will be deleted. In case if the _learnt_
-     * clause is unit, all decisions will be deleted
+    /* all entries in trail after decisions[level] will be deleted. In case if
+     * the _learnt_ clause is unit, all decisions will be deleted
      */
-    int next_level = ( level > 0 ) ? decisions[level] : decisions[0];
+    backtrack( level );
 
-    for ( int k = next_level ; k < trail.size(); ++k ) {
-        unassign( trail[k].var() );
+    if ( exchange && exchange->accepts( learnt.size(), lbd ) ) {
+        exchange->export_clause( exchange_id, learnt, lbd );
+        exported_clauses++;
+    }
 
-        if ( reasons[k] != -1 )
-            form[reasons[k]].reason_index = -1;
+    // unit propagate learnt clause, backtrack() moved the head of the queue
+    cref_t ref = add_learnt_clause( learnt, lbd );
+    if ( proof ) {
+        proof_add( ref );
     }
+}
 
-    // adjust trail accordingly
-    decisions.resize( level );
-    trail.resize( next_level );
-    reasons.resize( next_level );
+int solver::reason_level( lit_t l, reason_t reason ) const {
+    if ( reason.is_binary() ) {
+        return levels[reason.other.var()];
+    }
+
+    int level = 0;
+    for ( lit_t o : form[reason.cref] ) {
+        if ( o != l ) {
+            level = std::max( level, levels[o.var()] );
+        }
+    }
+    return level;
+}
+
+bool solver::backtrack_to_conflict() {
+    clause &c = form[conflict_idx];
+
+    // the two literals of the highest levels, c[0] on the highest
+    std::size_t first = 0, second = 1;
+    if ( levels[c[second].var()] > levels[c[first].var()] ) {
+        std::swap( first, second );
+    }
+    for ( std::size_t k = 2; k < c.size(); ++k ) {
+        int level = levels[c[k].var()];
+        if ( level > levels[c[first].var()] ) {
+            second = first;
+            first = k;
+        } else if ( level > levels[c[second].var()] ) {
+            second = k;
+        }
+    }
+
+    int level = levels[c[first].var()];
 
-    // unit propagate learnt clause
-    auto clref = form.next_index();
-    initialize_clause( learnt, clref );
-    add_learnt_clause( std::move( learnt ), clref ) ;
+    /* the clause must be watched by them, otherwise it is missed when the
+     * search backtracks below the conflict. Only a long clause can have
+     * them beyond the first two literals */
+    if ( first > 1 || second > 1 ) {
+        detach_clause( conflict_idx );
+
+        lit_t l2 = c[second];
+        std::swap( c[0], c[first] );
+        std::swap( c[1], c[std::find( c.begin(), c.end(), l2 ) - c.begin()] );
+
+        attach_clause( conflict_idx );
+    } else if ( first == 1 ) {
+        std::swap( c[0], c[1] );
+    }
+    assert( levels[c[0].var()] == level );
+
+    if ( levels[c[1].var()] == level ) {
+        backtrack( level );
+        return true;
+    }
+
+    // all other literals are false below _level_, c[0] is implied
+    backtrack( level - 1 );
+    if ( c.size() == 2 ) {
+        assign( c[0], reason_t::binary( c[1], conflict_idx ) );
+    } else {
+        assign( c[0], reason_t::clause( conflict_idx ) );
+        c.reason = 1;
+    }
+    missed_implications++;
 
-    // set head of propagation queue to last
-    index = trail.size() - 1;
+    return false;
 }
 
-int solver::compute_lbd( const std::vector< lit_t > &lits ) {
-    std::unordered_set< int > lvl_set;
+int solver::compute_lbd( std::span< const lit_t > lits ) {
+    // a new stamp marks all levels as not yet counted
+    if ( ++lbd_stamp == 0 ) {
+        std::fill( lbd_stamps.begin(), lbd_stamps.end(), 0 );
+        lbd_stamp = 1;
+    }
+
+    int lbd = 0;
     for ( lit_t l : lits ) {
-        lvl_set.insert( l.var() );
+        int lvl = levels[l.var()];
+        if ( lbd_stamps[lvl] != lbd_stamp ) {
+            lbd_stamps[lvl] = lbd_stamp;
+            lbd++;
+        }
+    }
+
+    return lbd;
+}
+
+std::span< const lit_t > solver::reason_literals( var_t v, lit_t &bin_lit ) {
+    reason_t r = reasons[v];
+
+    if ( r.is_binary() ) {
+        bin_lit = r.other;
+        return { &bin_lit, 1 };
     }
 
-    return lvl_set.size();
+    return { form[r.cref].begin(), form[r.cref].size() };
 }
 
-std::pair< clause, int > solver::analyze_conflict() {
+bool solver::lit_redundant( lit_t p, uint32_t abstract_levels ) {
+    assert( seen[p.var()] == SEEN_UNDEF || seen[p.var()] == SEEN_SOURCE );
+    assert( !reasons[p.var()].is_decision() );
+
+    lit_t bin_lit;
+    std::span< const lit_t > lits = reason_literals( p.var(), bin_lit );
+    analyze_stack.clear();
+
+    /* depth first search through the reasons of _p_, the stack stores the
+     * position in the reason of each literal on the path from _p_ */
+    std::size_t i = 0;
+    while ( true ) {
+        if ( i < lits.size() ) {
+            lit_t l = lits[i];
+            var_t lvar = l.var();
 
-    std::vector< lit_t > learnt_clause{ 0 };
+            // the implied literal itself, level 0 or already known removable
+            if ( lvar == p.var() || levels[lvar] == 0 || seen[lvar] == SEEN_SOURCE
+                 || seen[lvar] == SEEN_REMOVABLE ) {
+                i++;
+                continue;
+            }
+
+            // _l_ cannot be removed, neither can anything on the path to it
+            if ( reasons[lvar].is_decision() || seen[lvar] == SEEN_FAILED
+                 || ( abstract_level( lvar ) & abstract_levels ) == 0 ) {
+                analyze_stack.emplace_back( 0, p );
+                for ( auto [_, sl] : analyze_stack ) {
+                    if ( seen[sl.var()] == SEEN_UNDEF ) {
+                        seen[sl.var()] = SEEN_FAILED;
+                        analyze_toclear.push_back( sl );
+                    }
+                }
+                return false;
+            }
+
+            // recursively check _l_
+            analyze_stack.emplace_back( i, p );
+            i = 0;
+            p = l;
+            lits = reason_literals( p.var(), bin_lit );
+        } else {
+            // all literals in the reason of _p_ are removable
+            if ( seen[p.var()] == SEEN_UNDEF ) {
+                seen[p.var()] = SEEN_REMOVABLE;
+                analyze_toclear.push_back( p );
+            }
+
+            if ( analyze_stack.empty() ) {
+                break;
+            }
+
+            // continue with the parent, after the literal just checked
+            std::tie( i, p ) = analyze_stack.back();
+            analyze_stack.pop_back();
+            lits = reason_literals( p.var(), bin_lit );
+            i++;
+        }
+    }
+
+    return true;
+}
+
+std::tuple< std::vector< lit_t >, int, int > solver::analyze_conflict() {
+
+    std::vector< lit_t > learnt_clause{ lit_t() };
     int ind = trail.size() - 1;
-    lit_t uip = 0;
+    lit_t uip;
     int lits_remaining = 0;
 
-    std::vector< int > reasons_learnt;
+    // stores reason of currently resolved literal, starts with conflict clause
+    reason_t confl_reason = reason_t::clause( conflict_idx );
 
-    // stores index of currently resolved clause, starts with conflict clause
-    int confl_idx = conflict_idx;
+    // literals of a resolved binary clause
+    lit_t bin_lits[2];
 
     /* repeatedly resolve away literals until first uip
      * the seen map stores literals that are present in the final clause
      */
     do {
-        form.inc_activity( confl_idx );
+        std::span< lit_t > confl_lits;
+
+        if ( confl_reason.is_binary() ) {
+            bin_lits[0] = uip;
+            bin_lits[1] = confl_reason.other;
+            confl_lits = bin_lits;
+        } else {
+            form.inc_activity( confl_reason.cref );
 
-        clause& confl = form[confl_idx];
+            clause& confl = form[confl_reason.cref];
+            confl_lits = { confl.begin(), confl.size() };
 
-        for ( lit_t& l : confl.data ) {
+            // learnt clauses used in analysis may move to a better tier
+            if ( confl.learnt ) {
+                confl.last_conflict = conflicts;
+                if ( confl.lbd > 2 ) {
+                    confl.update_lbd( compute_lbd( confl_lits ) );
+                }
+            }
+        }
+
+        for ( lit_t& l : confl_lits ) {
 
             var_t lvar = l.var();
             if ( ( l != uip ) && levels[lvar] > 0 && !seen[lvar] ) {
-                seen[l.var()] = 1;
+                seen[l.var()] = SEEN_SOURCE;
 
                 increase_var_priority( lvar );
 
                 if ( levels[lvar] < current_level() ) {
                     learnt_clause.push_back( l );
-                    reasons_learnt.push_back( reasons[ind] );
                 }
                 else {
                     lits_remaining++;
@@ -443,39 +1294,37 @@ std::pair< clause, int > solver::analyze_conflict() {
             }
         }
 
-        int new_lbd = compute_lbd( confl.data );
-        confl.last_conflict = conflict_ctr;
-        confl.update_lbd( new_lbd );
-
-        // find next clause to resolve with
-        while ( !seen[trail[ind].var()] ) { --ind; };
+        // find next clause to resolve with, lower levels may be above it on the trail
+        while ( !seen[trail[ind].var()] || levels[trail[ind].var()] < current_level() ) {
+            --ind;
+        }
 
         uip = trail[ind];
-        seen[uip.var()] = 0;
+        seen[uip.var()] = SEEN_UNDEF;
         lits_remaining--;
 
-        confl_idx = reasons[ind];
+        confl_reason = reasons[uip.var()];
 
     } while (lits_remaining > 0);
 
     learnt_clause[0] = -uip;
-    auto to_clear = learnt_clause;
+    analyze_toclear = learnt_clause;
+
+    /* minimize learnt clause, remove literals implied by the rest of the
+     * clause. The levels of the clause are summarized in a bitmask, which
+     * lets lit_redundant() give up early on literals depending on other levels
+     */
+    uint32_t abstract_levels = 0;
+    for ( std::size_t i = 1; i < learnt_clause.size(); ++i ) {
+        abstract_levels |= abstract_level( learnt_clause[i].var() );
+    }
 
-    // simplify learnt clause
     int i, j;
     for ( i = j = 1; i < learnt_clause.size(); ++i) {
-        if ( reasons_learnt[i - 1] == -1) {
-            learnt_clause[j++] = learnt_clause[i];
-        } else {
-            clause& confl = form[reasons_learnt[i - 1]];
-            auto [l1, l2] = watches[reasons_learnt[i - 1]];
+        lit_t l = learnt_clause[i];
 
-            for ( lit_t l : confl.data ) {
-                if ( l != l2 && levels[l.var()] > 0 && !seen[l.var()] ) {
-                    learnt_clause[j++] = learnt_clause[i];
-                    break;
-                }
-            }
+        if ( reasons[l.var()].is_decision() || !lit_redundant( l, abstract_levels ) ) {
+            learnt_clause[j++] = l;
         }
     }
 
@@ -500,68 +1349,389 @@ std::pair< clause, int > solver::analyze_conflict() {
         backjump_level = levels[learnt_clause[1].var()];
     }
 
+    if ( branching == branching_kind::LRB ) {
+        bump_reason_side( learnt_clause );
+    }
+
     // clear seen
-    for ( const lit_t &l : to_clear ) {
-        seen[l.var()] = 0;
+    for ( const lit_t &l : analyze_toclear ) {
+        seen[l.var()] = SEEN_UNDEF;
+    }
+
+    if ( proof && proof->lrat() ) {
+        lrat_chain( learnt_clause, conflict_idx );
+    }
+
+    // learnt clause watches the UIP & highest DL literal
+    return { std::move( learnt_clause ), backjump_level, lbd };
+}
+
+
+bool solver::next_assumption( lit_t &next ) {
+    if ( assumed_level >= 0 ) {
+        return true;
+    }
+
+    for ( lit_t a : assumptions ) {
+        if ( asgn.falsifies_literal( a ) ) {
+            analyze_final( a );
+            return false;
+        }
+
+        if ( asgn.lit_unassigned( a ) ) {
+            next = a;
+            return true;
+        }
+    }
+
+    // all assumptions hold, no need to look again until they are backtracked
+    assumed_level = current_level();
+    return true;
+}
+
+void solver::analyze_final( lit_t p ) {
+    failed_assumptions.assign( 1, p );
+
+    if ( current_level() == 0 ) {
+        return;
     }
 
-    // construct clause ( init watches to UIP & highest DL literal )
-    clause learnt( std::move(learnt_clause), true, lbd, conflict_ctr );
+    seen[p.var()] = SEEN_SOURCE;
 
-    return { learnt, backjump_level };
+    // the decisions on the path to -p are the assumptions responsible for it
+    for ( int i = trail.size() - 1; i >= decisions[0]; --i ) {
+        var_t x = trail[i].var();
+        if ( !seen[x] ) {
+            continue;
+        }
+
+        if ( reasons[x].is_decision() ) {
+            failed_assumptions.push_back( trail[i] );
+        }
+        else {
+            lit_t bin_lit;
+            for ( lit_t l : reason_literals( x, bin_lit ) ) {
+                if ( l.var() != x && levels[l.var()] > 0 ) {
+                    seen[l.var()] = SEEN_SOURCE;
+                }
+            }
+        }
+
+        seen[x] = SEEN_UNDEF;
+    }
+
+    seen[p.var()] = SEEN_UNDEF;
 }
 
+lbool solver::solve( std::span< const lit_t > assumed ) {
+    scoped_timer timer( search_seconds );
+    search_start = timer.start;
 
-bool solver::solve() {
+    backtrack( 0 );
+    assumptions.assign( assumed.begin(), assumed.end() );
+    assumed_level = -1;
+    failed_assumptions.clear();
 
     if ( unsat ) {
-        return false;
+        return conclude_unsat();
     }
 
     // first UP
-    if ( !unit_propagation() ) { return false; }
+    if ( !unit_propagation() ) {
+        return conclude_unsat();
+    }
+
+    // local search alone, CDCL only decides the model it found
+    if ( local_search_mode == local_search_kind::ONLY ) {
+        while ( !local_search_round( 1 << 20 ) ) {
+            if ( interrupted() ) {
+                return std::nullopt;
+            }
+        }
+    }
 
     var_t var;
     bool pol;
+    lit_t assumption;
 
     while ( true ) {
 
-        var = get_unassigned( pol );
+        if ( interrupted() ) {
+            return std::nullopt;
+        }
+
+        if ( restarts.should_restart() && !restart() ) {
+            return conclude_unsat();
+        }
+
+        if ( conflicts >= next_reduce ) {
+            reduce_db();
+        }
+
+        if ( exchange && current_level() == 0 && !import_clauses() ) {
+            return conclude_unsat();
+        }
+
+        assumption = lit_t();
+        if ( !next_assumption( assumption ) ) {
+            return false;
+        }
+
+        if ( assumption.defined() ) {
+            decide( assumption.var(), assumption.pol() );
+            var = assumption.var();
+        } else {
+            var = get_unassigned( pol );
+        }
 
         if ( var == 0 ) {
             break;
         }
 
-        decide(var, pol);
+        // probes of inprocessing and lookahead also decide, but are not counted
+        decided++;
+        if ( !assumption.defined() ) {
+            decide( var, pol );
+        }
 
-        while ( !unit_propagation() ) {
-            if ( decisions.empty() ) {
-                return false;
+        while ( !propagate() ) {
+            if ( out_of_order && !backtrack_to_conflict() ) {
+                conflict_idx = cref_undef;
+                continue;
             }
 
-            inc_conflict_ctr();
-            if ( conflicts >= restart_limit ) {
-                restart();
-                break;
+            if ( decisions.empty() ) {
+                return conclude_unsat();
             }
-        
-            assert( conflict_idx != -1 );
 
-            auto [learnt, level] = analyze_conflict();
+            ++conflicts;
+            follow_phases = false;
+            save_trail_phases();
+
+            assert( conflict_idx != cref_undef );
+
+            auto [learnt, level, lbd] = [&] {
+                scoped_timer timer( analyze_seconds );
+                return analyze_conflict();
+            }();
             decay_var_priority();
             form.decay_activity();
 
+            learnt_clauses++;
+            lbd_sum += lbd;
+            restarts.on_conflict( lbd, trail.size() );
+
+            if ( report_interval > 0 && conflicts % 1024 == 0 ) {
+                report_progress();
+            }
+
             if ( level == 0 ) {
-                return false;
+                return conclude_unsat();
             }
 
             else if ( level == -1 ) {
                 level = 0;
             }
 
-            backjump( level, std::move( learnt ) );
+            // the learnt literal is assigned below the kept conflict level
+            if ( chrono_levels > 0 && level > 0 && current_level() - level > chrono_levels ) {
+                level = current_level() - 1;
+                out_of_order = true;
+                chrono_backtracks++;
+            }
+
+            backjump( level, std::move( learnt ), lbd );
+
+            // the conflict is learnt, its clause may be reduced from now on
+            conflict_idx = cref_undef;
         }
     }
 
     return true;
-};
+}
+
+bool solver::propagate() {
+    scoped_timer timer( propagate_seconds );
+    return unit_propagation();
+}
+
+void solver::report_progress() {
+    double seconds = search_seconds + std::chrono::duration< double >(
+                         std::chrono::steady_clock::now() - search_start ).count();
+    if ( seconds < next_report ) {
+        return;
+    }
+    next_report = seconds + report_interval;
+
+    std::cout << "c [ " << seconds << " s ] " << conflicts << " conflicts, " << decided
+              << " decisions, " << restarts.restarts << " restarts, "
+              << form.learnt.size() << " kept clauses, lbd "
+              << ( learnt_clauses ? double( lbd_sum ) / learnt_clauses : 0.0 ) << std::endl;
+}
+
+void solver::init_proof( const solver_options &opts ) {
+    if ( opts.proof == proof_format::NONE ) {
+        return;
+    }
+
+    proof = std::make_unique< proof_writer >( opts.proof_path, opts.proof );
+    if ( !proof->lrat() ) {
+        return;
+    }
+
+    // input clauses are numbered in the order of the file
+    clause_ids.resize( form.arena.size() );
+    for ( cref_t ref : form.base ) {
+        clause_ids[ref] = next_id++;
+    }
+
+    unit_ids.resize( form.var_count + 1 );
+    lrat_marks.resize( form.var_count + 1 );
+}
+
+void solver::proof_add( cref_t ref ) {
+    const clause &c = form[ref];
+    std::span< const lit_t > lits( c.begin(), c.size() );
+
+    if ( !proof->lrat() ) {
+        proof->add( lits );
+        return;
+    }
+
+    if ( clause_ids.size() < form.arena.size() ) {
+        clause_ids.resize( form.arena.memory.capacity() );
+    }
+
+    clause_ids[ref] = next_id++;
+    proof->add( clause_ids[ref], lits, lrat_hints );
+}
+
+void solver::proof_delete( cref_t ref ) {
+    if ( proof->lrat() ) {
+        proof->remove( clause_ids[ref] );
+    } else {
+        const clause &c = form[ref];
+        proof->remove( std::span< const lit_t >( c.begin(), c.size() ) );
+    }
+}
+
+uint64_t solver::unit_id( var_t v ) {
+    assert( levels[v] == 0 );
+
+    while ( !unit_ids[v] ) {
+        lit_t l = trail[proven_units++];
+        var_t x = l.var();
+
+        // unit clauses of the input or learnt ones are their own proof
+        if ( reasons[x].is_clause() && form[reasons[x].cref].size() == 1 ) {
+            unit_ids[x] = reason_id( x );
+            continue;
+        }
+
+        // the other literals of the reason are false at level 0, earlier on the trail
+        unit_hints.clear();
+        lit_t bin_lit;
+        for ( lit_t o : reason_literals( x, bin_lit ) ) {
+            if ( o.var() != x ) {
+                unit_hints.push_back( unit_ids[o.var()] );
+            }
+        }
+        unit_hints.push_back( reason_id( x ) );
+
+        unit_ids[x] = next_id++;
+        proof->add( unit_ids[x], std::span< const lit_t >( &l, 1 ), unit_hints );
+    }
+
+    return unit_ids[v];
+}
+
+void solver::lrat_chain( std::span< const lit_t > learnt, cref_t confl ) {
+    lrat_hints.clear();
+    lrat_units.clear();
+
+    if ( ++lrat_stamp == 0 ) {
+        std::fill( lrat_marks.begin(), lrat_marks.end(), 0 );
+        lrat_stamp = 1;
+    }
+
+    // literals of the learnt clause are false by assumption of the checker
+    for ( lit_t l : learnt ) {
+        lrat_marks[l.var()] = lrat_stamp;
+    }
+
+    const clause &c = form[confl];
+    for ( lit_t l : c ) {
+        lrat_visit( l.var() );
+    }
+
+    lrat_hints.push_back( clause_ids[confl] );
+    lrat_units.insert( lrat_units.end(), lrat_hints.begin(), lrat_hints.end() );
+    std::swap( lrat_hints, lrat_units );
+}
+
+void solver::lrat_visit( var_t v ) {
+    if ( lrat_marks[v] == lrat_stamp ) {
+        return;
+    }
+
+    lrat_marks[v] = lrat_stamp;
+    if ( levels[v] == 0 ) {
+        lrat_units.push_back( unit_id( v ) );
+        return;
+    }
+
+    /* depth first through the reasons, a reason is added after the reasons
+     * of its false literals, so that it is unit when the checker reaches it */
+    lrat_stack.assign( 1, { v, 0 } );
+    while ( !lrat_stack.empty() ) {
+        auto [x, i] = lrat_stack.back();
+        assert( !reasons[x].is_decision() );
+
+        lit_t bin_lit;
+        std::span< const lit_t > lits = reason_literals( x, bin_lit );
+
+        if ( i == lits.size() ) {
+            lrat_hints.push_back( reason_id( x ) );
+            lrat_stack.pop_back();
+            continue;
+        }
+
+        lrat_stack.back().second++;
+        var_t u = lits[i].var();
+        if ( u == x || lrat_marks[u] == lrat_stamp ) {
+            continue;
+        }
+
+        lrat_marks[u] = lrat_stamp;
+        if ( levels[u] == 0 ) {
+            lrat_units.push_back( unit_id( u ) );
+        } else {
+            lrat_stack.push_back( { u, 0 } );
+        }
+    }
+}
+
+bool solver::close_proof() {
+    return !proof || proof->close();
+}
+
+bool solver::conclude_unsat() {
+    unsat = true;
+
+    if ( !proof || proof_concluded ) {
+        return false;
+    }
+
+    proof_concluded = true;
+    if ( !proof->lrat() ) {
+        proof->add( std::span< const lit_t >() );
+    }
+    // an empty input clause needs no proof
+    else if ( conflict_idx != cref_undef ) {
+        lrat_chain( {}, conflict_idx );
+        proof->add( next_id++, {}, lrat_hints );
+    }
+
+    proof->flush();
+    return false;
+}
@@ -1,27 +1,52 @@
+#pragma once
 #include "solver_types.hpp"
+#include "local_search.hpp"
 #include "logger.hpp"
-#include <fstream>
+#include "options.hpp"
+#include "proof.hpp"
+#include "restart.hpp"
+#include "sharing.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <random>
-#include <unordered_set>
+#include <span>
+#include <tuple>
 
 struct solver {
 
-    // rng with fixed seed
-    std::mt19937 rng{ 42 };
+    // seeded with solver_options::seed, also seeds the local search
+    std::mt19937 rng;
 
-    logger log;
+    /* polarity selection */
+    phase_kind phases;
 
-    // solved formula
-    formula form;
+    /* set by another thread to stop the search, solve() then returns nullopt */
+    const std::atomic< bool > *terminate = nullptr;
+
+    /* clause sharing of a portfolio run, _exchange_id_ is this solver's ring */
+    clause_exchange *exchange = nullptr;
+    int exchange_id = 0;
 
+    long long exported_clauses = 0;
+    long long imported_clauses = 0;
 
-    // index to confl clause
-    int confl_clause;
+    std::vector< lit_t > import_buffer;
+    std::vector< lit_t > import_lits;
 
     /*
-     * a vector of watched literals in the same order as the clauses in the formula
+     * adds the clauses shared by the other solvers, simplified by the level 0
+     * assignment, returns false if the formula became unsatisfiable
      */
-    std::vector< std::pair< lit_t, lit_t > > watches;
+    bool import_clauses();
+
+    logger log;
+
+    // solved formula
+    formula form;
+
 
     /**
      * SOLVER STATE
@@ -41,10 +66,13 @@ struct solver {
      **/
     std::size_t index;
 
+    /* number of literals processed by unit_propagation() */
+    long long propagations = 0;
+
     /*
-     * current index of conflict
+     * reference to the current conflict clause
      */
-    int conflict_idx = -1;
+    cref_t conflict_idx = cref_undef;
 
     /**
      * stores indices into _trail_ corresponding to decisions made during
@@ -58,20 +86,43 @@ struct solver {
     std::vector< lit_t > trail;
 
     /* *
-     * tracks watched literals accros clauses, maps literals -> indices of
-     * clauses in which they are currently watched
+     * tracks watched literals accros clauses, maps literals -> references of
+     * clauses in which they are currently watched, the watched literals of
+     * a clause are always the first two. Every clause appears exactly in the
+     * lists of its two watches, there are no stale entries
      */
     lit_map occurs;
 
     /**
-     * seen literals, used for resolution in CDCL
+     * implication lists of binary clauses, maps literals -> clauses
+     * containing them together with the other literal of the clause, binary
+     * clauses are propagated from here without touching the clause arena
+     */
+    lit_map bin_occurs;
+
+    /**
+     * seen literals, used for resolution in CDCL, minimization of the learnt
+     * clause caches whether a variable is removable / failed here
     */
+    enum seen_mark {
+        SEEN_UNDEF = 0,
+        SEEN_SOURCE = 1,
+        SEEN_REMOVABLE = 2,
+        SEEN_FAILED = 3
+    };
+
     std::vector< int > seen;
 
+    /* variables marked in _seen_ during analysis */
+    std::vector< lit_t > analyze_toclear;
+
+    /* dfs stack of lit_redundant(), ( position in reason, literal ) */
+    std::vector< std::pair< std::size_t, lit_t > > analyze_stack;
+
     /**
-     * stores reason (clause) for each literal in _trail_ 
+     * stores reason (clause / binary literal) for each assigned variable
      */
-    std::vector< int > reasons;
+    std::vector< reason_t > reasons;
 
     /**
      * levels of variables, used for CDCL
@@ -82,84 +133,312 @@ struct solver {
      * VARIABLE SELECTION
      */
 
+    branching_kind branching;
+
     /**
      * stores the EVSIDS max heap structure containing all variables 
      */
     evsids_heap heap;
 
+    /* VMTF queue, only kept up to date if _branching_ uses it */
+    vmtf_queue queue;
+
+    /* variables bumped in the current conflict analysis, moved to the end
+     * of _queue_ in the order of their stamps afterwards */
+    std::vector< var_t > vmtf_bumped;
+
+    bool uses_vmtf() const {
+        return branching == branching_kind::VMTF
+               || ( branching == branching_kind::MIXED && !restarts.stable() );
+    }
+
+    /*
+     * LRB, the priority of a variable is an exponential moving average of
+     * its learning rate, updated when it is unassigned. The rate is the
+     * number of conflicts the variable took part in ( _participated_ ) or
+     * was in the reason of a literal of the learnt clause ( _reasoned_ ),
+     * divided by the conflicts since it was assigned ( _assigned_at_ ).
+     * The step size of the average decreases from 0.4 to 0.06.
+     */
+    std::vector< long long > assigned_at;
+    std::vector< uint32_t > participated;
+    std::vector< uint32_t > reasoned;
+    double lrb_step = 0.4;
+
+    void update_learning_rate( var_t v );
+    void bump_reason_side( std::span< const lit_t > learnt );
+
     // increment for evsids
     double inc = 1;
 
     // decay factor used to multiply the increment
-    const double var_decay = 1 / 0.95;
+    const double var_decay;
 
+    // ends the bumping of a conflict
     void decay_var_priority();
     void increase_var_priority( var_t v );
 
+    /* does the decision of _v_ rank above that of _u_ */
+    bool ranks_above( var_t v, var_t u ) const;
+
     // select next branching variable
     var_t get_unassigned( bool &polarity );
 
+    /*
+     * STATISTICS
+     *
+     * cheap counters and timers of the search, kept always. The times are
+     * accumulated by scoped timers around the propagation and analysis of
+     * the search loop, reduce_db() and restart(), which includes
+     * inprocessing and walks.
+     */
+    /* decisions of solve() and its assumptions, not the probes of
+     * inprocessing or lookahead */
+    long long decided = 0;
+    long long learnt_clauses = 0;
+    long long lbd_sum = 0;
+    long long watch_visits = 0;
+
+    double search_seconds = 0;
+    double propagate_seconds = 0;
+    double analyze_seconds = 0;
+    double reduce_seconds = 0;
+    double restart_seconds = 0;
+
+    /* start of the current solve() */
+    std::chrono::steady_clock::time_point search_start;
+
+    /* seconds between progress lines on stdout, 0 for none */
+    const double report_interval;
+    double next_report;
+
+    /* prints a progress line when the next one is due */
+    void report_progress();
+
+    /* unit_propagation() of the search loop, timed */
+    bool propagate();
+
 
 
     /* RESTARTS */
 
     /* number of conflicts */
-    int conflicts = 0;
+    long long conflicts = 0;
+
+    /* decides when to restart, see restart.hpp */
+    restart_policy restarts;
+
+    /* restart, runs inprocessing when it is due. Returns false if that
+     * found the formula UNSAT */
+    bool restart();
+
+    /* lowest level whose decision ranks below the next heap candidate, the
+     * levels under it would be decided again after a full restart */
+    int reuse_trail_level();
+
+    /* FORGETTING CLAUSES */
+
+    /* conflicts between reductions, grows by _reduce_inc_ each time */
+    long long reduce_interval = 2000;
+    int reduce_inc = 300;
+    long long next_reduce = 2000;
+
+    long long reductions = 0;
+    long long deleted_clauses = 0;
+
+    /*
+     * forgets half of the LOCAL learnt clauses, detaches them from the watch
+     * lists and compacts the arena when enough memory is wasted
+     */
+    void reduce_db();
+
+    /* deleted references of the last reduce_db(), only kept for proofs */
+    std::vector< cref_t > forgotten;
+
+    /*
+     * INPROCESSING
+     *
+     * at some restarts the solver goes back to level 0 to simplify:
+     *  - failed literal probing, a literal whose propagation conflicts is
+     *    learnt negated through the usual conflict analysis
+     *  - vivification of CORE and MID learnt clauses, the negations of the
+     *    literals of a clause are decided one by one, the clause is cut
+     *    short at a conflict or an implied literal and loses the literals
+     *    implied false
+     *
+     * Each round may spend _inprocess_effort_ of the propagations of the
+     * search since the last round.
+     */
+    bool inprocessing;
+
+    long long inprocess_interval = 5000;
+    int inprocess_inc = 5000;
+    long long next_inprocess = 5000;
 
-    /* restart limit */
-    int restart_limit = 100;
+    double inprocess_effort = 0.1;
 
-    /* compute next limit with Luby sequence */
-    int max_limit = 100;
+    /* search propagations at the end of the last round */
+    long long searched = 0;
 
-    void change_restart_limit() {
-        restart_limit *= 2;
+    /* next variable to probe, probing continues where the last round stopped */
+    var_t probe_next = 0;
 
-        if (restart_limit > max_limit) {
-            max_limit *= 2;
-            restart_limit = 100;
-        }
+    std::vector< lit_t > vivify_lits;
+
+    /* STATISTICS */
+    long long inprocess_rounds = 0;
+    long long inprocess_propagations = 0;
+    double inprocess_seconds = 0;
+    long long failed_literals = 0;
+    long long vivify_tried = 0;
+    long long vivify_shortened = 0;
+    long long vivify_deleted = 0;
+
+    /* runs a round of inprocessing at level 0, false if the formula is UNSAT */
+    bool inprocess();
+
+    // probes literals until _propagations_ reaches _limit_
+    bool probe_literals( long long limit );
+    bool vivify_clauses( long long limit );
+    bool vivify_clause( cref_t ref );
+
+    // removes the watches of the long clause _ref_
+    void detach_clause( cref_t ref );
+
+    /*
+     * REPHASING
+     *
+     * the saved phases are reset every _rephase_interval_ conflicts, the
+     * interval grows by _rephase_inc_ each time. The kinds of reset follow a
+     * fixed cycle:
+     *
+     * ORIGINAL - the initial phase of all variables
+     * INVERTED - its negation
+     * BEST     - the phases of the longest trail since the last rephase
+     * WALK     - the best phases, improved by local search
+     * RANDOM   - random phases
+     *
+     * With TARGET phases, decisions in stable mode take the phases of the
+     * longest conflict-free trail since the last restart.
+     */
+    enum class rephase_kind {
+        ORIGINAL, INVERTED, BEST, WALK, RANDOM
+    };
+
+    long long rephase_interval = 500;
+    int rephase_inc = 100;
+    long long next_rephase = 500;
+
+    long long rephases = 0;
+    long long walks = 0;
+
+    /* phase of unsaved variables */
+    bool original_phase() const {
+        return phases == phase_kind::SAVED_POSITIVE;
     }
 
-    /* restart */
-    void restart();
+    // at a conflict, updates the target and best phases from the trail
+    void save_trail_phases();
+    void rephase();
 
-    /* FORGETTING CLAUSES */
+    /* LOCAL SEARCH */
+
+    local_search_kind local_search_mode;
+
+    /* built on first use, again when base clauses were added since */
+    std::unique_ptr< local_search > sls;
+
+    /* flips of a walk rephase per search propagation since the last walk */
+    double local_search_effort = 0.2;
+    long long walk_searched = 0;
+
+    /* the saved phases satisfy the formula, they are decided as they are
+     * until the next conflict */
+    bool follow_phases = false;
+
+    void build_local_search();
+
+    /* runs local search from the saved phases for at most _flips_ flips and
+     * saves its best assignment, true if it satisfies the formula */
+    bool local_search_round( long long flips );
+
+    /* PROOF */
+
+    std::unique_ptr< proof_writer > proof;
+
+    /* the empty clause was written */
+    bool proof_concluded = false;
+
+    /* writes out the rest of the proof, false if it is incomplete */
+    bool close_proof();
 
-    /* local forgetting period */
-    int forget_period = 30000;
+    /* LRAT ids of clauses by reference and of level 0 units by variable,
+     * _proven_units_ is the prefix of the trail that has unit ids */
+    std::vector< uint64_t > clause_ids;
+    std::vector< uint64_t > unit_ids;
+    uint64_t next_id = 1;
+    std::size_t proven_units = 0;
 
-    /* mid demotion check period */
-    int demote_period = 10000;
+    /* hints of the last learnt clause, level 0 units first */
+    std::vector< uint64_t > lrat_hints;
+    std::vector< uint64_t > lrat_units;
+    std::vector< uint64_t > unit_hints;
 
-    /* conflict ctr (max. 30k) */
-    int conflict_ctr = 1;
+    /* vars visited by lrat_chain(), stamped like _lbd_stamps_ */
+    std::vector< uint32_t > lrat_marks;
+    uint32_t lrat_stamp = 0;
+    std::vector< std::pair< var_t, std::size_t > > lrat_stack;
 
-    void inc_conflict_ctr() {
-        if (++conflict_ctr > 30000) {
-            conflict_ctr = 1;
-        }
-        ++conflicts;
+    void init_proof( const solver_options &opts );
 
-        if ( conflicts % demote_period == 0 ) {
-            form.demote_clauses( conflict_ctr, demote_period );
-        } else if ( conflict_ctr % forget_period == 0 ) {
-            forget_period = 15000;
-            form.forget_clauses( conflict_idx );
-        }
+    // writes the addition of _ref_, with _lrat_hints_ in LRAT
+    void proof_add( cref_t ref );
+    void proof_delete( cref_t ref );
+
+    uint64_t reason_id( var_t v ) {
+        return clause_ids[reasons[v].cref];
     }
 
+    /* id of the unit clause of the level 0 variable _v_, the units of the
+     * level 0 trail up to _v_ are derived on the first request */
+    uint64_t unit_id( var_t v );
+
+    /* computes the hints deriving _learnt_ from the conflict _confl_ */
+    void lrat_chain( std::span< const lit_t > learnt, cref_t confl );
+    void lrat_visit( var_t v );
+
+    /* marks the formula UNSAT, writing the empty clause to the proof */
+    bool conclude_unsat();
+
     /**
      * CONSTRUCTORS
      */
-    solver(formula _form) : form(std::move(_form))
-                          , watches( form.clause_count )
+    solver( formula _form, const solver_options &opts = {} )
+                          : rng( opts.seed )
+                          , phases( opts.phases )
+                          , form(std::move(_form))
+                          , var_decay( 1 / opts.var_decay )
+                          , restarts( opts.restarts )
+                          , inprocessing( opts.inprocess )
+                          , local_search_mode( opts.local_search )
                           , asgn(form.var_count)
+                          , branching( opts.branching )
                           , heap( form.var_count )
+                          , queue( form.var_count )
+                          , assigned_at( form.var_count + 1 )
+                          , participated( form.var_count + 1 )
+                          , reasoned( form.var_count + 1 )
                           , occurs( form.var_count )
+                          , bin_occurs( form.var_count )
                           , seen( form.var_count + 1 )
+                          , reasons( form.var_count + 1 )
+                          , lbd_stamps( form.var_count + 1 )
                           , levels( form.var_count + 1 ) 
+                          , report_interval( opts.report_interval )
+                          , next_report( opts.report_interval )
+                          , chrono_levels( opts.chrono_levels )
     {
+        init_proof( opts );
         initialize_structures();
     }
 
@@ -170,21 +449,61 @@ struct solver {
      */
 
     // initialize _occurs_, check empty / unit clauses before solve()
-    void initialize_clause( clause& cl, int clref );
+    void initialize_clause( cref_t clref );
+
+    // watches the first two literals of a non-unit clause
+    void attach_clause( cref_t clref );
     void initialize_structures();
 
-    void add_base_clause(clause c);
-    void add_learnt_clause(clause c, size_t clref);
+    /*
+     * INCREMENTAL INTERFACE
+     *
+     * clauses and variables can be added between calls of solve(), each
+     * call takes its own assumptions. Learnt clauses, activities and saved
+     * phases are kept from one call to the next.
+     */
+
+    // adds a fresh variable, returns it
+    var_t new_var();
+
+    // makes variables up to _count_ available
+    void reserve_vars( int count );
+
+    /*
+     * adds a clause of the problem, simplified by the level 0 assignment,
+     * returns cref_undef if it is empty or not stored at all. Not allowed
+     * while writing a proof, throws std::logic_error
+     */
+    cref_t add_base_clause( std::vector< lit_t > lits );
+
+    /* was _a_ among the assumptions responsible for the last UNSAT answer */
+    bool failed( lit_t a ) const {
+        return std::find( failed_assumptions.begin(), failed_assumptions.end(), a )
+               != failed_assumptions.end();
+    }
+
+    cref_t add_learnt_clause( const std::vector< lit_t > &lits, int lbd );
+
+    // removes watches of clauses deleted from the formula
+    void detach_deleted();
+
+    /*
+     * compacts the clause arena, dropping deleted clauses and remapping
+     * _reasons_ and _occurs_ to the new references
+     */
+    void collect_garbage();
 
     /**
      * MODEL OUTPUT/TESTING functions
      */
     std::vector< bool > get_model();
+
+    /* adds the counters of the search and of the enabled features to _report_ */
+    void collect_stats( stats_report &report ) const;
     std::string get_model_string();
-    void output_model( const std::string &filename );
 
     void log_solver_state( const std::string &title, bool all_clauses );
-    void log_clause( const clause &c, const std::string &title, auto idx );
+    void log_clause( const clause &c, const std::string &title );
 
 
 
@@ -202,13 +521,30 @@ struct solver {
         return rng() % 2;
     }
 
-    int compute_lbd( const std::vector< lit_t >& lits );
+    /* number of distinct decision levels among _lits_ */
+    int compute_lbd( std::span< const lit_t > lits );
+
+    /* per level stamps of compute_lbd(), avoids clearing a set each call */
+    std::vector< uint32_t > lbd_stamps;
+    uint32_t lbd_stamp = 0;
+
+    /* bit representing the level of _v_ in a set of levels */
+    uint32_t abstract_level( var_t v ) const {
+        return 1u << ( levels[v] & 31 );
+    }
+
+    /* literals of the reason of _v_, _bin_lit_ backs binary reasons */
+    std::span< const lit_t > reason_literals( var_t v, lit_t &bin_lit );
+
+    /* checks whether _p_ is implied by the other literals of the learnt
+     * clause ( those marked SEEN_SOURCE ) */
+    bool lit_redundant( lit_t p, uint32_t abstract_levels );
 
     // assigns val v to variable x, adds new decision level to _decisions_
     void decide( var_t x, bool v );
 
-    // assigns, but without the new DL
-    void assign( var_t x, bool v );
+    // assigns literal l with its reason, but without the new DL
+    void assign( lit_t l, reason_t reason );
 
     // unassigns variable, inserting back into evsids heap and updating asgn struct
     void unassign( var_t x );
@@ -219,24 +555,78 @@ struct solver {
     bool unit_propagation();
 
     /**
-     * backtracks to the previous DL, flipping the last decision,
-     * as well as nullifying the resulting unit propagations,
+     * undoes all assignments above decision level _level_
      */
-    void backtrack();
+    void backtrack( int level );
 
     /**
-     * performs conflict analysis, returning a new learnt clause
-     * and backjump index
+     * performs conflict analysis, returning a new learnt clause,
+     * backjump index and the clause LBD
      */
-    std::pair< clause, int > analyze_conflict();
+    std::tuple< std::vector< lit_t >, int, int > analyze_conflict();
 
     /**
      * backjumps to the level of the last UIP
     */
-    void backjump( int level, clause learnt );
+    void backjump( int level, std::vector< lit_t > learnt, int lbd );
+
+    /*
+     * CHRONOLOGICAL BACKTRACKING
+     *
+     * a backjump over more than _chrono_levels_ levels only undoes the
+     * conflict level, the learnt literal is assigned below it. The levels
+     * on the trail are then out of order: implied literals get the highest
+     * level of their reason instead of the current one, backtrack() keeps
+     * the literals of lower levels above the target, and a conflict may be
+     * below the current level. In that case the search first backtracks to
+     * the conflict level, and if only one literal of the conflict is on it,
+     * the clause is a missed implication and assigns that literal instead.
+     */
+    const int chrono_levels;
+
+    /* levels on the trail may be out of order, until backtracking to 0 */
+    bool out_of_order = false;
+
+    /* highest level of the literals of _reason_ other than _l_ */
+    int reason_level( lit_t l, reason_t reason ) const;
+
+    /* backtracks to the level of the conflict. Returns false if the conflict
+     * was a missed implication, assigned instead of analyzed */
+    bool backtrack_to_conflict();
+
+    /* STATISTICS */
+    long long chrono_backtracks = 0;
+    long long missed_implications = 0;
+
+    /* ASSUMPTIONS */
+
+    /* decided in order before any other variable during solve() */
+    std::vector< lit_t > assumptions;
+
+    /* all assumptions hold at this level and below, -1 if not known */
+    int assumed_level = -1;
+
+    /*
+     * after solve() returned false, the assumptions that together
+     * contradict the formula, empty if the formula itself is UNSAT
+     */
+    std::vector< lit_t > failed_assumptions;
+
+    /* sets _next_ to the next assumption to decide, if any, returns false
+     * if an assumption is falsified */
+    bool next_assumption( lit_t &next );
+
+    /* collects the assumptions implying -p into _failed_assumptions_ */
+    void analyze_final( lit_t p );
+
+    bool interrupted() const {
+        return terminate && terminate->load( std::memory_order_relaxed );
+    }
 
     /*
-     * solves the formula _form_, returning true if it is SAT
+     * solves the formula _form_ under _assumptions_, returning true if it is
+     * SAT, false if it is UNSAT and nullopt if the search was interrupted
+     * through _terminate_. Can be called again, learnt clauses are kept.
      */
-    bool solve();
+    lbool solve( std::span< const lit_t > assumptions = {} );
 };
@@ -6,8 +6,10 @@
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <new>
 #include <optional>
 #include <queue>
+#include <span>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -16,53 +18,122 @@
 using var_t = int;
 using lbool = std::optional< bool >;
 
+/* reference to a clause, i.e. its offset in the clause arena */
+using cref_t = uint32_t;
+constexpr cref_t cref_undef = UINT32_MAX;
+
+/*
+ * literal packed as 2 * var + sign, the sign bit is set for negative
+ * literals. Var 0 is never used, so code 0 is the undefined literal. Arrays
+ * over literals are indexed directly by the code
+ */
 struct lit_t {
-    int lit;
+    uint32_t code;
 
-    lit_t() : lit(0) { /*std::cout << "WARNING: default lit constr called\n";*/ };
+    lit_t() : code( 0 ) { }
 
-    lit_t(std::convertible_to< int > auto&& l) {
-        lit = l;
-    }
+    lit_t( var_t v, bool pol ) : code( 2 * v + !pol ) { }
 
-    operator int() {
-        return lit;
+    static lit_t from_dimacs( int l ) {
+        return lit_t( std::abs( l ), l > 0 );
     }
 
-    auto& operator=(std::convertible_to< int > auto&& l) {
-        lit = l;
-        return *this;
+    int to_dimacs() const {
+        return pol() ? var() : -var();
     }
 
     bool operator==( const lit_t &rhs ) const {
-        return lit == rhs.lit;
+        return code == rhs.code;
+    }
+
+    bool operator<( const lit_t &rhs ) const {
+        return code < rhs.code;
+    }
+
+    lit_t operator-() const {
+        lit_t l;
+        l.code = code ^ 1;
+        return l;
     }
 
-    inline int var() const {
-        return std::abs( lit );
+    inline var_t var() const {
+        return code >> 1;
     }
 
     inline bool pol() const {
-        return lit > 0;
+        return !( code & 1 );
     }
 
     inline void flip() {
-        lit *= -1;
+        code ^= 1;
+    }
+
+    inline bool defined() const {
+        return code != 0;
     }
 };
 
 
+/*
+ * reason of an assignment, either a reference to the implying clause or, for
+ * binary clauses, directly the other ( false ) literal of the clause. Both
+ * are empty for decisions
+ */
+struct reason_t {
+    cref_t cref = cref_undef;
+    lit_t other;
+
+    static reason_t clause( cref_t ref ) {
+        reason_t r;
+        r.cref = ref;
+        return r;
+    }
+
+    /* _ref_ is only needed for proofs */
+    static reason_t binary( lit_t l, cref_t ref ) {
+        reason_t r;
+        r.cref = ref;
+        r.other = l;
+        return r;
+    }
+
+    bool is_decision() const {
+        return cref == cref_undef && !other.defined();
+    }
+
+    bool is_binary() const {
+        return other.defined();
+    }
+
+    bool is_clause() const {
+        return cref != cref_undef && !other.defined();
+    }
+};
+
+/*
+ * entry of a watch list, carries a literal of the watched clause so that
+ * satisfied clauses can be skipped without touching the clause itself. In the
+ * binary watch lists the blocker is the literal implied by the clause
+ */
+struct watch {
+    cref_t cref;
+    lit_t blocker;
+};
+
 /* occurs struct */
 struct lit_map {
-    std::vector< std::vector< int > > data;
+    std::vector< std::vector< watch > > data;
     int var_count;
 
-    lit_map( int count ) : data( 2 * count + 1 ), var_count( count ) {}
+    lit_map( int count ) : data( 2 * count + 2 ), var_count( count ) {}
+
+    void grow( int count ) {
+        data.resize( 2 * count + 2 );
+        var_count = count;
+    }
 
-    std::vector< int >& operator[]( lit_t l ) {
-        int lvar = l.var();
-        int index = ( l.pol() ) ? lvar : lvar + var_count;
-        return data[index];
+    std::vector< watch >& operator[]( lit_t l ) {
+        return data[l.code];
     }
 };
 
@@ -206,6 +277,31 @@ struct evsids_heap {
         }
     }
 
+    /* restores the heap after priorities[v] changed in either direction */
+    void update( var_t v ) {
+        if ( indices[v] != -1 ) {
+            propagate( v );
+            heapify( v );
+        }
+    }
+
+    /* removes _v_ from the heap, e.g. an eliminated variable */
+    void remove( var_t v ) {
+        int idx = indices[v];
+        if ( idx == -1 ) {
+            return;
+        }
+
+        heap_swap( idx, heap.size() - 1 );
+        heap.pop_back();
+        indices[v] = -1;
+
+        if ( idx < (int) heap.size() ) {
+            propagate( heap[idx] );
+            heapify( heap[idx] );
+        }
+    }
+
     var_t extract_max(){
         // signal empty heap
         if ( heap.size() == 0 ) {
@@ -225,6 +321,16 @@ struct evsids_heap {
         return v_max;
     }
 
+    /* adds variables up to _count_ with priority _priority_ */
+    void grow( int count, double priority ) {
+        priorities.resize( count + 1, priority );
+        indices.resize( count + 1, -1 );
+        for ( var_t v = vars_count + 1; v <= count; ++v ) {
+            insert( v );
+        }
+        vars_count = count;
+    }
+
     void insert( var_t v ) {
         // v is not in the heap
         if ( indices[v] == -1 ) {
@@ -236,58 +342,169 @@ struct evsids_heap {
 
 };
 
-
 struct assignment {
-    const int period = 4 * 100;
     std::size_t vars_count;
-    std::vector< lbool > asgn;
-    int decision_count = 0;
+
+    /* value of every literal, 1 - true, -1 - false, 0 - unassigned */
+    std::vector< int8_t > vals;
+
+    /* saved phases, the last value of each variable */
     std::vector< lbool > last_phase;
 
-    assignment(std::size_t count) : vars_count( count ), asgn( count + 1 ), last_phase( count + 1 ) { }
+    /* values on the longest conflict-free trail since the last restart
+     * ( target ) and on the longest one since the last rephase ( best ),
+     * the sizes are those of the trails */
+    std::vector< lbool > target_phase;
+    std::vector< lbool > best_phase;
+    std::size_t target_size = 0;
+    std::size_t best_size = 0;
 
-    lbool& operator[](var_t var) {
-        return asgn[var];
+    assignment(std::size_t count) : vars_count( count ), vals( 2 * count + 2 ),
+                                    last_phase( count + 1 ), target_phase( count + 1 ),
+                                    best_phase( count + 1 ) { }
+
+    void grow( std::size_t count ) {
+        vars_count = count;
+        vals.resize( 2 * count + 2 );
+        last_phase.resize( count + 1 );
+        target_phase.resize( count + 1 );
+        best_phase.resize( count + 1 );
+    }
+
+    int8_t value( lit_t lit ) const {
+        return vals[lit.code];
     }
 
     lbool& saved_phase(var_t var) {
         return last_phase[var];
     }
 
-    void assign( var_t var, bool v ) {
-        asgn[var] = v;
-        last_phase[var] = v;
+    void assign( lit_t lit ) {
+        vals[lit.code] = 1;
+        vals[lit.code ^ 1] = -1;
+        last_phase[lit.var()] = lit.pol();
     }
+
     void unassign( var_t var ) {
-        asgn[var] = std::nullopt;
+        vals[2 * var] = 0;
+        vals[2 * var + 1] = 0;
     }
 
     bool var_unassigned( var_t var ) const {
-        return !asgn[var];
+        return vals[2 * var] == 0;
     }
 
     bool lit_unassigned( lit_t lit ) const {
-        return var_unassigned( lit.var() );
+        return vals[lit.code] == 0;
     }
 
-    // input condition: only called on literals that are assigned
     // returns whether this literal is satisfied by assignment
-    bool satisfies_literal( lit_t lit ) {
-        lbool& asgn_l = asgn[lit.var()];
+    bool satisfies_literal( lit_t lit ) const {
+        return vals[lit.code] > 0;
+    }
 
-        return asgn_l && asgn_l == lit.pol();
+    bool falsifies_literal( lit_t lit ) const {
+        return vals[lit.code] < 0;
     }
 
 };
 
+/*
+ * variable-move-to-front queue, a doubly linked list of the variables
+ * ordered by the time they were last bumped. A bumped variable moves to the
+ * end of the queue, decisions take the last unassigned variable. Every
+ * variable after _search_ is assigned, so the search for the next decision
+ * starts there, and an unassigned variable only moves _search_ if its stamp
+ * is larger. All operations but the search are O(1).
+ */
+struct vmtf_queue {
+
+    /* neighbours in the queue, 0 at the ends */
+    std::vector< var_t > prev;
+    std::vector< var_t > next;
+
+    /* time of the last bump, increasing along the queue */
+    std::vector< uint64_t > stamps;
+    uint64_t stamp = 0;
+
+    var_t first = 0;
+    var_t last = 0;
+    var_t search = 0;
+
+    int vars_count = 0;
+
+    vmtf_queue( int count ) {
+        grow( count );
+    }
+
+    void unlink( var_t v ) {
+        ( prev[v] ? next[prev[v]] : first ) = next[v];
+        ( next[v] ? prev[next[v]] : last ) = prev[v];
+    }
+
+    void append( var_t v ) {
+        prev[v] = last;
+        next[v] = 0;
+        ( last ? next[last] : first ) = v;
+        last = v;
+        stamps[v] = ++stamp;
+    }
+
+    /* moves _v_ to the end of the queue */
+    void bump( var_t v, bool unassigned ) {
+        if ( v != last ) {
+            if ( search == v ) {
+                search = prev[v];
+            }
+            unlink( v );
+            append( v );
+        }
+
+        if ( unassigned ) {
+            search = v;
+        }
+    }
+
+    void on_unassign( var_t v ) {
+        if ( !search || stamps[v] > stamps[search] ) {
+            search = v;
+        }
+    }
+
+    /* last unassigned variable of the queue, 0 if all are assigned */
+    var_t next_unassigned( const assignment &asgn ) {
+        while ( search && !asgn.var_unassigned( search ) ) {
+            search = prev[search];
+        }
+        return search;
+    }
+
+    /* removes _v_ from the queue, e.g. an eliminated variable */
+    void remove( var_t v ) {
+        if ( search == v ) {
+            search = prev[v];
+        }
+        unlink( v );
+        prev[v] = next[v] = 0;
+    }
+
+    /* adds variables up to _count_ at the end */
+    void grow( int count ) {
+        prev.resize( count + 1 );
+        next.resize( count + 1 );
+        stamps.resize( count + 1 );
+        for ( var_t v = vars_count + 1; v <= (var_t) count; ++v ) {
+            append( v );
+        }
+        vars_count = count;
+        search = last;
+    }
+};
+
+/*
+ * clause header, the literals are stored inline right after it in the arena
+ */
 struct clause {
-    
-    enum clause_status {
-        UNDETERMINED = 0,
-        SATISFIED = 1,
-        CONFLICT = 2,
-        UNIT = 3
-    };
 
     enum learnt_type {
         CORE = 0,
@@ -295,53 +512,52 @@ struct clause {
         LOCAL = 2
     };
 
-    bool learnt;
-    clause_status status;
-    int lbd;
-    int_fast8_t reason_index = -1;
-    learnt_type type;
-    
+    uint32_t _size;
+
+    unsigned learnt : 1;
+
+    /* removed from the database, memory is reclaimed by the next gc */
+    unsigned deleted : 1;
+
+    /* moved by the gc, data[0] holds the new reference */
+    unsigned relocated : 1;
+
+    /* clause is a reason of some literal on the trail */
+    unsigned reason : 1;
+
+    unsigned type : 2;
+
+    /* already tried by vivification */
+    unsigned vivified : 1;
+    unsigned lbd : 25;
+
     /* last conflict */
     int last_conflict;
 
-    std::vector< lit_t > data;
+    float activity;
 
-    clause(std::vector< lit_t > _data, bool _learnt = false, int _lbd = 0, int conf_ctr = 0)
-     : learnt(_learnt), data(std::move(_data)), lbd(_lbd), last_conflict(conf_ctr) {
+    clause( const std::vector< lit_t > &lits, bool _learnt, int _lbd, int conf_ctr )
+     : _size( lits.size() ), learnt( _learnt ), deleted( 0 ), relocated( 0 ), reason( 0 ),
+       type( LOCAL ), vivified( 0 ), lbd( 0 ), last_conflict( conf_ctr ), activity( 0 ) {
+        std::copy( lits.begin(), lits.end(), data() );
         if ( learnt ) {
-            status = UNIT;
-            
-            if ( lbd <= 3 ) {
-                type = CORE;
-            } else if ( lbd <= 6 ) {
-                type = MID;
-            } else {
-                type = LOCAL;
-            }
-        }
-        else if ( data.empty() ) {
-            status = CONFLICT;
+            set_lbd( _lbd );
         }
-        else if ( data.size() == 1 ) {
-            status = UNIT;
-        } else {
-            status = UNDETERMINED;
-
-            // UNIT cuz only 1 literal
-            lit_t l = data[0];
-            for ( lit_t lit : data ) {
-                if ( l != lit ) {
-                    return;
-                }
-            }
+    }
 
-            status = UNIT;
-        }
+    /* copy constructor used by the gc, moves the literals along */
+    clause( const clause &from ) : _size( from._size ), learnt( from.learnt ), deleted( 0 ),
+                                   relocated( 0 ), reason( from.reason ), type( from.type ),
+                                   vivified( from.vivified ), lbd( from.lbd ),
+                                   last_conflict( from.last_conflict ),
+                                   activity( from.activity ) {
+        std::copy( from.begin(), from.end(), data() );
     }
 
-    /* if smaller -> update */
-    void update_lbd( int new_lbd ) {
-        lbd = std::min( lbd, new_lbd );
+    clause& operator=( const clause & ) = delete;
+
+    void set_lbd( int new_lbd ) {
+        lbd = new_lbd;
         if ( lbd <= 3 ) {
             type = CORE;
         } else if ( lbd <= 6 ) {
@@ -351,115 +567,246 @@ struct clause {
         }
     }
 
-    auto size() const {
-        return data.size();
+    /* if smaller -> update */
+    void update_lbd( int new_lbd ) {
+        if ( new_lbd < static_cast< int >( lbd ) ) {
+            set_lbd( new_lbd );
+        }
+    }
+
+    lit_t *data() {
+        return reinterpret_cast< lit_t * >( this + 1 );
+    }
+
+    const lit_t *data() const {
+        return reinterpret_cast< const lit_t * >( this + 1 );
+    }
+
+    lit_t& operator[]( std::size_t i ) {
+        return data()[i];
+    }
+
+    const lit_t& operator[]( std::size_t i ) const {
+        return data()[i];
+    }
+
+    lit_t *begin() { return data(); }
+    lit_t *end() { return data() + _size; }
+    const lit_t *begin() const { return data(); }
+    const lit_t *end() const { return data() + _size; }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    cref_t relocation() const {
+        return data()[0].code;
+    }
+
+    /* size of the clause in arena words */
+    static std::size_t words( std::size_t lits ) {
+        return ( sizeof( clause ) + lits * sizeof( lit_t ) ) / sizeof( uint32_t );
     }
 };
 
-struct formula {
-    std::vector< clause > base;
-    std::vector< clause > learnt;
-    std::vector< uint_fast8_t > is_valid;
-    std::vector< double > activity;
-    std::vector< int > empty_indices;
-    
-    std::size_t clause_count;
-    std::size_t var_count;
-    int demote_limit = 30000;
+static_assert( sizeof( clause ) % sizeof( uint32_t ) == 0 );
+static_assert( sizeof( lit_t ) == sizeof( uint32_t ) );
 
-    /* increment for forgetting */
-    double inc = 1;
+/*
+ * all clauses are stored in one contiguous block of 32-bit words, each clause
+ * is its header followed by its literals and is addressed by its offset
+ */
+struct clause_arena {
+    std::vector< uint32_t > memory;
 
-    /* decay */
-    const double decay = 1 / 0.95;
+    /* words occupied by deleted clauses */
+    std::size_t wasted = 0;
 
-    formula( std::vector< clause > _base, std::size_t count_c, std::size_t count_v ) : base(std::move( _base )), 
-                                                                                       clause_count( count_c ),
-                                                                                       var_count( count_v ) {}
+    clause_arena() = default;
+    explicit clause_arena( std::size_t capacity ) {
+        memory.reserve( capacity );
+    }
 
-    clause& operator[]( std::size_t index ) {
-        if ( index < base.size() ) {
-            return base[index];
-        } else {
-            return learnt[index - base.size()];
+    clause& operator[]( cref_t ref ) {
+        return *reinterpret_cast< clause * >( &memory[ref] );
+    }
+
+    const clause& operator[]( cref_t ref ) const {
+        return *reinterpret_cast< const clause * >( &memory[ref] );
+    }
+
+    /* invalidates references to clauses in the arena */
+    cref_t alloc( const std::vector< lit_t > &lits, bool learnt, int lbd = 0, int conf_ctr = 0 ) {
+        cref_t ref = memory.size();
+        memory.resize( memory.size() + clause::words( lits.size() ) );
+        new ( &memory[ref] ) clause( lits, learnt, lbd, conf_ctr );
+        return ref;
+    }
+
+    void free( cref_t ref ) {
+        clause &c = ( *this )[ref];
+        c.deleted = 1;
+        wasted += clause::words( c.size() );
+    }
+
+    /* moves the clause _ref_ into _to_ ( once ), updating the reference */
+    void reloc( cref_t &ref, clause_arena &to ) {
+        clause &c = ( *this )[ref];
+        // the copy below clears the flag, a freed clause would come back
+        assert( !c.deleted );
+        if ( c.relocated ) {
+            ref = c.relocation();
+            return;
         }
+
+        cref_t new_ref = to.memory.size();
+        to.memory.resize( to.memory.size() + clause::words( c.size() ) );
+        new ( &to.memory[new_ref] ) clause( c );
+
+        c.relocated = 1;
+        c.data()[0].code = new_ref;
+        ref = new_ref;
     }
 
-    const clause& operator[]( std::size_t index ) const {
-        if ( index < base.size() ) {
-            return base[index];
-        } else {
-            return learnt[index - base.size()];
+    std::size_t size() const {
+        return memory.size();
+    }
+};
+
+/*
+ * clauses removed by variable elimination, a model of the remaining formula
+ * is extended to the eliminated variables by going through them backwards
+ * and flipping the pivot of each falsified clause
+ */
+struct model_extension {
+
+    /* clauses in order of elimination, pivot first, each ends with lit_t() */
+    std::vector< lit_t > lits;
+
+    std::vector< bool > eliminated;
+
+    bool is_eliminated( var_t v ) const {
+        return v < (var_t) eliminated.size() && eliminated[v];
+    }
+
+    void push( lit_t pivot, std::span< const lit_t > clause ) {
+        lits.push_back( pivot );
+        for ( lit_t l : clause ) {
+            if ( l != pivot ) {
+                lits.push_back( l );
+            }
         }
+        lits.push_back( lit_t() );
     }
 
-    bool is_valid_clause( std::size_t index ) const {
-        if ( index < base.size() ) {
-            return 1;
-        } else {
-            return is_valid[index - base.size()];
+    /* _model_[v - 1] is the value of _v_ */
+    void extend( std::vector< bool > &model ) const {
+        auto satisfied = [&]( lit_t l ) { return model[l.var() - 1] == l.pol(); };
+
+        std::size_t end = lits.size();
+        while ( end > 0 ) {
+            // find start of the last clause before _end_
+            std::size_t start = end - 1;
+            while ( start > 0 && lits[start - 1].defined() ) {
+                start--;
+            }
+
+            bool sat = false;
+            for ( std::size_t i = start; i < end - 1 && !sat; ++i ) {
+                sat = satisfied( lits[i] );
+            }
+
+            if ( !sat ) {
+                model[lits[start].var() - 1] = lits[start].pol();
+            }
+
+            end = start;
         }
     }
+};
 
-    void add_base_clause(clause c) {
-        base.push_back(std::move(c));
-        clause_count++;
+struct formula {
+    clause_arena arena;
+    std::vector< cref_t > base;
+    std::vector< cref_t > learnt;
+
+    std::size_t clause_count = 0;
+    std::size_t var_count;
+
+    /* the input contains an empty clause */
+    bool empty_clause = false;
+
+    /* filled by preprocessing */
+    model_extension extension;
+
+    /* MID clauses not used in analysis for this many conflicts become LOCAL */
+    int demote_limit = 10000;
+
+    /* increment for forgetting */
+    float inc = 1;
+
+    /* decay */
+    const float decay = 1 / 0.999;
+
+    formula( std::size_t count_v ) : var_count( count_v ) {}
+
+    clause& operator[]( cref_t ref ) {
+        return arena[ref];
     }
 
-    size_t next_index() {
-        if ( empty_indices.size() > 0 ) {
-            size_t idx = empty_indices.back();
-            empty_indices.pop_back();
-            return base.size() + idx;
-        } else {
-            return size();
-        }
+    const clause& operator[]( cref_t ref ) const {
+        return arena[ref];
     }
 
-    void add_learnt_clause(clause c, size_t idx) {
-        idx -= base.size();
-        if ( idx < learnt.size() ) {
-            learnt[idx] = std::move(c);
-            is_valid[idx] = 1;
-            activity[idx] = 0;
-        } else {
-            learnt.push_back(std::move(c));
-            is_valid.push_back(1);
-            activity.push_back(0);
+    /* duplicate literals are removed, empty clause is only recorded */
+    cref_t add_base_clause( std::vector< lit_t > &lits ) {
+        std::sort( lits.begin(), lits.end() );
+        lits.erase( std::unique( lits.begin(), lits.end() ), lits.end() );
+
+        clause_count++;
+        if ( lits.empty() ) {
+            empty_clause = true;
+            return cref_undef;
         }
+
+        cref_t ref = arena.alloc( lits, false );
+        base.push_back( ref );
+        return ref;
+    }
+
+    cref_t add_learnt_clause( const std::vector< lit_t > &lits, int lbd, int conf_ctr ) {
+        cref_t ref = arena.alloc( lits, true, lbd, conf_ctr );
+        learnt.push_back( ref );
         clause_count++;
+        return ref;
     }
 
     size_t size() const {
         return base.size() + learnt.size();
     }
 
-    /* move mid to local if not used in last 30k conflicts */
-    void demote_clauses( int conflict_ctr, int demote_period ) {
-        for ( int i = 0; i < learnt.size(); i++ ) {
-            clause& c = learnt[i];
-            if ( !is_valid_clause(i) || c.type != clause::MID ) {
-                continue;
-            }
-            
-            if ( c.last_conflict < conflict_ctr - demote_limit) {
+    /* move mid to local if not used in last _demote_limit_ conflicts */
+    void demote_clauses( int conflicts ) {
+        for ( cref_t ref : learnt ) {
+            clause& c = arena[ref];
+            if ( c.type == clause::MID && c.last_conflict < conflicts - demote_limit ) {
                 c.type = clause::LOCAL;
             }
-            c.last_conflict -= demote_period;
         }
     }
 
     /* increase clause activity */
-    void inc_activity( int idx ) {
-        if ( idx < base.size() ) {
+    void inc_activity( cref_t ref ) {
+        clause& c = arena[ref];
+        if ( !c.learnt ) {
             return;
         }
 
-        if ( (activity[idx - base.size()] + inc) > 1e100 ) {
-            for ( double& act : activity ) {
-                act *= 1e-100;
+        if ( ( c.activity += inc ) > 1e20 ) {
+            for ( cref_t l : learnt ) {
+                arena[l].activity *= 1e-20;
             }
-            inc *= 1e-100;
+            inc *= 1e-20;
         }
     }
 
@@ -468,26 +815,42 @@ struct formula {
         inc *= decay;
     }
 
-    /* forget bottom half of LOCAL clauses based on their activity */
-    void forget_clauses( int conflict_idx ) {
-        std::vector< std::pair< double, int > > act;
-        for ( int i = 0; i < learnt.size(); i++ ) {
-            if ( !is_valid_clause(i) || i == conflict_idx ) {
-                continue;
-            }
+    /* forget bottom half of LOCAL clauses, ordered by activity and then by LBD,
+     * CORE clauses are kept forever. Returns the number of deleted clauses, the
+     * caller is responsible for detaching them from the watch lists. The
+     * deleted references are stored in _forgotten_ if given */
+    std::size_t forget_clauses( int conflicts, std::vector< cref_t > *forgotten = nullptr ) {
+        demote_clauses( conflicts );
 
-            clause& c = learnt[i];
-            if ( c.type == clause::LOCAL && c.reason_index == -1 ) {
-                act.emplace_back( activity[i], i );
+        std::vector< cref_t > local;
+        for ( cref_t ref : learnt ) {
+            clause& c = arena[ref];
+            if ( c.type == clause::LOCAL && !c.reason ) {
+                local.push_back( ref );
             }
         }
 
-        std::sort( act.begin(), act.end() );
+        // least useful first
+        std::sort( local.begin(), local.end(), [&]( cref_t l, cref_t r ) {
+            const clause &cl = arena[l];
+            const clause &cr = arena[r];
+            if ( cl.activity != cr.activity ) {
+                return cl.activity < cr.activity;
+            }
+            return cl.lbd > cr.lbd;
+        } );
 
-        for ( int i = 0; i < act.size() / 2; i++ ) {
-            int idx = act[i].second;
-            empty_indices.push_back( idx );
-            is_valid[idx] = 0;
+        std::size_t count = local.size() / 2;
+        for ( std::size_t i = 0; i < count; i++ ) {
+            arena.free( local[i] );
+            clause_count--;
         }
+
+        if ( forgotten ) {
+            forgotten->assign( local.begin(), local.begin() + count );
+        }
+
+        std::erase_if( learnt, [&]( cref_t ref ) { return arena[ref].deleted; } );
+        return count;
     }
 };
@@ -0,0 +1,95 @@
+#pragma once
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* adds the seconds from its construction to its destruction to _total_ */
+struct scoped_timer {
+    double &total;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    explicit scoped_timer( double &total ) : total( total ) { }
+
+    ~scoped_timer() {
+        total += std::chrono::duration< double >( std::chrono::steady_clock::now()
+                                                  - start ).count();
+    }
+};
+
+/*
+ * STATISTICS REPORT
+ *
+ * named values of a run, printed as aligned "c name: value" comment lines
+ * or as one JSON object, whose keys are the names with underscores for
+ * spaces. Text values are quoted in JSON, numbers are not.
+ */
+struct stats_report {
+
+    struct entry {
+        std::string name;
+        std::string value;
+        bool text;
+    };
+
+    std::vector< entry > entries;
+
+    void add( const std::string &name, long long value ) {
+        entries.push_back( { name, std::to_string( value ), false } );
+    }
+
+    void add( const std::string &name, double value ) {
+        std::ostringstream str;
+        str << value;
+        entries.push_back( { name, str.str(), false } );
+    }
+
+    void add( const std::string &name, const std::string &value ) {
+        entries.push_back( { name, value, true } );
+    }
+
+    void add( const std::string &name, const char *value ) {
+        add( name, std::string( value ) );
+    }
+
+    void append( const stats_report &other ) {
+        entries.insert( entries.end(), other.entries.begin(), other.entries.end() );
+    }
+
+    void print( std::ostream &out ) const {
+        for ( const entry &e : entries ) {
+            out << "c " << std::left << std::setw( 19 ) << e.name + ":" << std::right
+                << e.value << "\n";
+        }
+    }
+
+    void print_json( std::ostream &out ) const {
+        out << "{";
+        for ( std::size_t i = 0; i < entries.size(); ++i ) {
+            std::string key = entries[i].name;
+            for ( char &c : key ) {
+                if ( c == ' ' ) {
+                    c = '_';
+                }
+            }
+
+            out << ( i ? ", " : " " ) << quoted( key ) << ": "
+                << ( entries[i].text ? quoted( entries[i].value ) : entries[i].value );
+        }
+        out << " }";
+    }
+
+    /* _str_ as a JSON string */
+    static std::string quoted( const std::string &str ) {
+        std::string res = "\"";
+        for ( char c : str ) {
+            if ( c == '"' || c == '\\' ) {
+                res += '\\';
+            }
+            res += c;
+        }
+        return res + "\"";
+    }
+};
@@ -0,0 +1,3 @@
+# parse-time benchmark, run from the test directory after building
+../build/fousaty-parse-bench ./big_fat_unsat/*
+../build/fousaty-parse-bench ./all_satisfiable_200/*
@@ -1,16 +1,19 @@
 import sys
-# model file is of format var : valuation \in {0, 1}
+# model is read from the "v" lines of the solver output, "-" for stdin
 
 def parse_model( model_file ):
     var = dict()
-    with open(model_file) as mf:
-        line = mf.readline()
-
-        words = line.split(' ')
-        for litstr in words[2:-2]:
-            lit = int(litstr)
-            var[str(abs(lit))] = lit > 0
-            
+    with ( sys.stdin if model_file == '-' else open(model_file) ) as mf:
+        for line in mf:
+            words = line.split()
+            if not words or words[0] != 'v':
+                continue
+
+            for litstr in words[1:]:
+                if litstr.lstrip('-').isdigit() and litstr != '0':
+                    lit = int(litstr)
+                    var[str(abs(lit))] = lit > 0
+
     return var
 
 def parse_dimacs( filename ):
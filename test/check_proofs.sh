@@ -0,0 +1,18 @@
+# checks DRAT and LRAT proofs of the UNSAT instances, run from the test
+# directory after building
+failed=0
+
+for f in ./all_unsat/*; do
+	../build/fousaty --proof=proof.drat $f > /dev/null
+	../build/fousaty-check $f proof.drat > /dev/null || { echo "DRAT proof of $f not verified"; failed=1; }
+
+	../build/fousaty --proof=proof.lrat --proof-format=lrat $f > /dev/null
+	../build/fousaty-check --lrat $f proof.lrat > /dev/null || { echo "LRAT proof of $f not verified"; failed=1; }
+done
+
+rm -f proof.drat proof.lrat
+
+if [ $failed -eq 0 ]; then
+	echo all proofs verified
+fi
+exit $failed